@@ -0,0 +1,185 @@
+// Copyright © 2020-2021 Alex Qzminsky.
+// License: MIT. All rights reserved.
+
+/// \brief Emission strategies benchmark
+///
+/// \details Measures the cost of the `color`, `font` and `reset` manipulators through
+/// several sinks and compares it with `printf` of the same literal escape sequences.
+/// Usage: `tesc_bench [iterations]`. The report is written to `stderr`, since `stdout`
+/// is redirected to `/dev/null` for the measurements
+
+#include "tesc.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+
+using namespace tesc;
+
+namespace
+{
+    /**
+     * \brief Prevents the compiler from discarding a computed value
+    */
+    template <typename T>
+    inline void keep (T const& value)
+    {
+        asm volatile ("" : : "g"(&value) : "memory");
+    }
+
+    /**
+     * \brief Result of a single measurement
+    */
+    struct result
+    {
+        double ns_per_call;
+        double bytes_per_sec;
+    };
+
+    /**
+     * \brief Hides the value from the optimizer, so the formatting can't be done at compile time
+    */
+    template <typename T>
+    inline auto opaque (T value) -> T
+    {
+        asm volatile ("" : "+r"(value));
+        return value;
+    }
+
+    /**
+     * \brief Runs `body` the given number of times and returns the best of several repetitions
+     *
+     * \param iterations Number of calls per repetition
+     * \param bytes_per_call Number of bytes emitted by a single call
+     * \param body Measured action
+    */
+    template <typename Body>
+    auto measure (std::size_t iterations, std::size_t bytes_per_call, Body&& body) -> result
+    {
+        using clock = std::chrono::steady_clock;
+
+        auto best = std::chrono::nanoseconds::max();
+
+        for (int rep = 0; rep < 5; ++rep)
+        {
+            auto start = clock::now();
+            body(iterations);
+            best = std::min(best, std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start));
+        }
+
+        auto ns = (double)best.count() / (double)iterations;
+        return { ns, (double)bytes_per_call / ns * 1e9 };
+    }
+
+    /**
+     * \brief Measures a manipulator through all the sinks and prints the report rows
+     *
+     * \param name Name of the manipulator
+     * \param literal The same escape sequence as a literal, for `printf`
+     * \param emit Applies the manipulator to an output stream
+     * \param format Builds the escape sequence from the (opaque) arguments, for the raw buffer
+     * \param direct Applies the same change to an `emergency` writer
+    */
+    template <typename Emit, typename Format, typename Direct>
+    void run (char const* name, char const* literal, std::size_t iterations, int fd, Emit emit, Format format, Direct direct)
+    {
+        auto size = std::strlen(literal);
+
+        auto baseline = measure(iterations, size, [&] (std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) std::printf("%s", literal);
+        });
+
+        std::vector<std::pair<char const*, result>> rows;
+
+        rows.emplace_back("ostringstream", measure(iterations, size, [&] (std::size_t n) {
+            std::ostringstream os;
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                emit(os);
+                if (os.tellp() > 1 << 16) os.str({});
+            }
+            keep(os);
+        }));
+
+        rows.emplace_back("cout>/dev/null", measure(iterations, size, [&] (std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) emit(std::cout);
+        }));
+
+        rows.emplace_back("raw buffer", measure(iterations, size, [&] (std::size_t n) {
+            static char buffer[1 << 16];
+            std::size_t used = 0;
+
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                auto seq = format();
+
+                if (used + escape::capacity > sizeof buffer) used = 0;
+                std::memcpy(buffer + used, seq.data(), seq.size());
+                used += seq.size();
+            }
+            keep(buffer);
+        }));
+
+        rows.emplace_back("fd (emergency)", measure(iterations, size, [&] (std::size_t n) {
+            emergency out{ fd };
+            for (std::size_t i = 0; i < n; ++i) direct(out);
+        }));
+
+        std::fprintf(stderr, "%-7s %-14s %12.2f %14.1f %10s\n",
+            name, "printf", baseline.ns_per_call, baseline.bytes_per_sec / 1e6, "-");
+
+        for (auto& [sink, res] : rows)
+        {
+            std::fprintf(stderr, "%-7s %-14s %12.2f %14.1f %+9.1f%%\n",
+                name, sink, res.ns_per_call, res.bytes_per_sec / 1e6,
+                (res.ns_per_call / baseline.ns_per_call - 1) * 100);
+        }
+    }
+}
+
+int main (int argc, char** argv)
+{
+    std::size_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000;
+
+    if (!std::freopen("/dev/null", "w", stdout))
+    {
+        std::perror("freopen");
+        return EXIT_FAILURE;
+    }
+    auto null_fd = ::open("/dev/null", O_WRONLY);
+    if (null_fd < 0)
+    {
+        std::perror("open");
+        return EXIT_FAILURE;
+    }
+
+    std::fprintf(stderr, "%-7s %-14s %12s %14s %10s\n", "manip", "sink", "ns/call", "MB/s", "overhead");
+
+    run("color", "\033[97;41m", iterations, null_fd,
+        [] (std::ostream& os) { os << color{ bright(face::white) | back::red }; },
+        [] { return to_escape(opaque(bright(face::white)), opaque(back::red)); },
+        [] (emergency& out) { out << (bright(face::white) | back::red); }
+    );
+
+    run("font", "\033[1;4;23m", iterations, null_fd,
+        [] (std::ostream& os) { os << font{ style::bold | style::underline }; },
+        [] { return to_escape(opaque(style::bold | style::underline)); },
+        [] (emergency& out) { out << (style::bold | style::underline); }
+    );
+
+    run("reset", "\033[0m", iterations, null_fd,
+        [] (std::ostream& os) { os << reset; },
+        [] { return reset_escape; },
+        [] (emergency& out) { out << reset; }
+    );
+
+    ::close(null_fd);
+    return EXIT_SUCCESS;
+}
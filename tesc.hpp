@@ -14,12 +14,63 @@
 
 static_assert(__cplusplus >= 201700L, "C++17 or higher is required");
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <iostream>
+#include <streambuf>
+#include <string_view>
+#include <type_traits>
 #include <utility>
 
+#if __has_include(<unistd.h>)
+#   include <cerrno>
+#   include <unistd.h>
+#   define TESC_HAS_POSIX 1
+#else
+#   define TESC_HAS_POSIX 0
+#endif
+
+// Under `TESC_DISABLE` manipulators are constant expressions which neither emit nor store anything
+#ifdef TESC_DISABLE
+#   define TESC_CONSTEXPR constexpr
+#else
+#   define TESC_CONSTEXPR inline
+#endif
+
+// Under `TESC_THREAD_LOCAL` each thread has its own manipulators settings
+#ifdef TESC_THREAD_LOCAL
+#   define TESC_STATE_STORAGE thread_local
+#else
+#   define TESC_STATE_STORAGE
+#endif
+
 namespace tesc
 {
+    /// Whether the manipulators emit escape sequences at all
+#ifdef TESC_DISABLE
+    inline constexpr bool enabled = false;
+#else
+    inline constexpr bool enabled = true;
+#endif
+
+    /**
+     * \internal
+     * \brief Stateless stand-in for a stored setting when the library is disabled
+    */
+    template <typename T>
+    struct _null_slot
+    {
+        explicit constexpr _null_slot (T) {}
+
+        constexpr auto operator = (T) const -> _null_slot const& { return *this; }
+        constexpr operator T () const { return T{}; }
+    };
+
+    /// \internal Storage type of the manipulators settings
+    template <typename T>
+    using _slot_t = std::conditional_t<enabled, T, _null_slot<T>>;
+
     // SECTION Manipulators parameters
     /**
      * \enum face
@@ -66,7 +117,7 @@ namespace tesc
      * \return Joint color pair
     */
     [[nodiscard]]
-    auto operator | (face clr_1, back clr_2) -> std::pair<face, back>
+    constexpr auto operator | (face clr_1, back clr_2) -> std::pair<face, back>
     {
         return std::make_pair(clr_1, clr_2);
     }
@@ -80,7 +131,7 @@ namespace tesc
      * \return Joint color pair
     */
     [[nodiscard]]
-    auto operator | (back clr_1, face clr_2) -> std::pair<face, back>
+    constexpr auto operator | (back clr_1, face clr_2) -> std::pair<face, back>
     {
         return clr_2 | clr_1;
     }
@@ -94,9 +145,9 @@ namespace tesc
      * \return Joint font style
     */
     [[nodiscard]]
-    auto operator | (style f_1, style f_2) -> style
+    constexpr auto operator | (style f_1, style f_2) -> style
     {
-        return style{ (uint8_t)f_1 | (uint8_t)f_2 };
+        return style{ (uint8_t)((uint8_t)f_1 | (uint8_t)f_2) };
     }
 
     /**
@@ -107,11 +158,11 @@ namespace tesc
      * \return Brighter color
     */
     [[nodiscard]]
-    auto bright (face clr) -> face
+    constexpr auto bright (face clr) -> face
     {
-        if ((uint8_t)clr >= 90) return clr;
+        if (clr == face::none || (uint8_t)clr >= 90) return clr;
 
-        return face{ 60 + (uint8_t)clr };
+        return face{ (uint8_t)(60 + (uint8_t)clr) };
     }
 
     /**
@@ -122,11 +173,513 @@ namespace tesc
      * \return Brighter color
     */
     [[nodiscard]]
-    auto bright (back clr) -> back
+    constexpr auto bright (back clr) -> back
+    {
+        if (clr == back::none || (uint8_t)clr >= 100) return clr;
+
+        return back{ (uint8_t)(60 + (uint8_t)clr) };
+    }
+    // !SECTION
+
+    // SECTION Escape sequences
+    /**
+     * \class escape
+     *
+     * \brief Fixed-capacity byte string holding a ready-to-write escape sequence
+     *
+     * \note Never allocates, so it may be built and written even from a signal handler
+    */
+    class escape
+    {
+    public:
+
+        static constexpr std::size_t capacity = 48;
+
+    private:
+
+        char _data[capacity] = {};
+        uint8_t _size = 0;
+
+    public:
+
+        /**
+         * \brief Default constructor. Creates an empty sequence
+        */
+        constexpr escape () = default;
+
+        /**
+         * \brief Appends a single character
+         *
+         * \param ch Character to append
+         *
+         * \return Reference to the sequence itself
+        */
+        constexpr auto push (char ch) -> escape&
+        {
+            if (_size < capacity) _data[_size++] = ch;
+            return *this;
+        }
+
+        /**
+         * \brief Appends a decimal representation of a numeric code
+         *
+         * \param code Numeric code (e.g. SGR parameter)
+         *
+         * \return Reference to the sequence itself
+        */
+        constexpr auto push (unsigned code) -> escape&
+        {
+            char digits[10] = {};
+            int n = 0;
+
+            do digits[n++] = char('0' + code % 10); while (code /= 10);
+            while (n) push(digits[--n]);
+
+            return *this;
+        }
+
+        /**
+         * \brief Appends another sequence
+         *
+         * \param other Sequence to append
+         *
+         * \return Reference to the sequence itself
+        */
+        constexpr auto push (escape const& other) -> escape&
+        {
+            for (std::size_t i = 0; i < other.size(); ++i) push(other._data[i]);
+            return *this;
+        }
+
+        /**
+         * \brief Returns a pointer to the sequence bytes (not null-terminated)
+        */
+        [[nodiscard]]
+        constexpr auto data () const -> char const*
+        {
+            return _data;
+        }
+
+        /**
+         * \brief Returns a number of bytes in the sequence
+        */
+        [[nodiscard]]
+        constexpr auto size () const -> std::size_t
+        {
+            return _size;
+        }
+
+        /**
+         * \brief Predicate. Checks if the sequence contains no bytes
+        */
+        [[nodiscard]]
+        constexpr auto empty () const -> bool
+        {
+            return !_size;
+        }
+
+        /**
+         * \brief Returns the sequence as a string view
+        */
+        [[nodiscard]]
+        constexpr auto view () const -> std::string_view
+        {
+            return { _data, _size };
+        }
+
+        /**
+         * \brief Writes the sequence bytes to the output stream as-is
+         *
+         * \param os Output stream
+         * \param seq Escape sequence
+         *
+         * \return Reference to the output stream
+        */
+        friend auto operator << (std::ostream& os, escape const& seq) -> std::ostream&
+        {
+            return os.write(seq.data(), (std::streamsize)seq.size());
+        }
+    };
+
+    /**
+     * \brief Builds the sequence which the `color` manipulator emits for a given colors pair
+     *
+     * \param fg Text foreground color
+     * \param bg Text background color
+     *
+     * \return Escape sequence
+    */
+    [[nodiscard]]
+    constexpr auto to_escape (face fg, back bg) -> escape
+    {
+        escape seq;
+        seq.push('\033').push('[');
+
+        // Zero-valued colors don't have any effect
+        if (fg != face::none)
+        {
+            seq.push((unsigned)fg);
+            if (bg != back::none) seq.push(';');
+        }
+        if (bg != back::none) seq.push((unsigned)bg);
+
+        return seq.push('m'), seq;
+    }
+
+    /**
+     * \brief Builds the sequence which the `font` manipulator emits for a given style
+     *
+     * \param st Font style
+     *
+     * \return Escape sequence
+    */
+    [[nodiscard]]
+    constexpr auto to_escape (style st) -> escape
+    {
+        auto has = [st] (uint8_t bit) { return !(uint8_t)st ? false : ((uint8_t)st & bit) == bit; };
+
+        unsigned modif[] = {
+            has(1) ? 1u : 22u,
+            has(2) ? 3u : 23u,
+            has(4) ? 4u : 24u,
+        };
+
+        auto order = [] (unsigned& a, unsigned& b) { if (a > b) { unsigned t = a; a = b; b = t; } };
+
+        // Sorting an array due to cancellers which must be the last
+        order(modif[0], modif[1]);
+        order(modif[1], modif[2]);
+        order(modif[0], modif[1]);
+
+        escape seq;
+        seq.push('\033').push('[').push(modif[0]).push(';').push(modif[1]).push(';').push(modif[2]);
+
+        return seq.push('m'), seq;
+    }
+
+    /**
+     * \internal
+     * \brief Precomputed font style sequences, indexed by the `style` value
+    */
+    inline constexpr escape _style_escapes[] = {
+        to_escape(style{ 0 }), to_escape(style{ 1 }), to_escape(style{ 2 }), to_escape(style{ 3 }),
+        to_escape(style{ 4 }), to_escape(style{ 5 }), to_escape(style{ 6 }), to_escape(style{ 7 }),
+    };
+
+    /// The sequence which the `reset` manipulator emits
+    inline constexpr std::string_view reset_escape = "\033[0m";
+    // !SECTION
+
+    // SECTION Emission instrumentation
+    /// \internal Kinds of manipulator applications
+    enum : int { _color_event, _font_event, _reset_event };
+
+#ifdef TESC_INSTRUMENT
+    namespace metrics
     {
-        if ((uint8_t)clr >= 100) return clr;
+        /**
+         * \struct stats
+         *
+         * \brief Plain snapshot of emission counters
+        */
+        struct stats
+        {
+            uint64_t escape_bytes = 0;    ///< Bytes of escape sequences written by manipulators
+            uint64_t text_bytes = 0;      ///< Other bytes (counted for metered streams only)
+            uint64_t manipulators = 0;    ///< Number of `color`, `font` and `reset` applications
+            uint64_t redundant = 0;       ///< Applications which re-stated the effective state
+            uint64_t resets = 0;          ///< Number of `reset` applications
+        };
+
+        /**
+         * \class counters
+         *
+         * \brief Emission counters updated with relaxed atomic operations
+        */
+        class counters
+        {
+            std::atomic<uint64_t> _escape_bytes{ 0 },
+                                  _text_bytes{ 0 },
+                                  _manipulators{ 0 },
+                                  _redundant{ 0 },
+                                  _resets{ 0 };
+
+            friend class metered_stream;
+            friend void _account (std::ostream&, int, std::size_t, uint32_t);
+
+        public:
+
+            /**
+             * \brief Returns current values of the counters
+             *
+             * \note The fields are read independently and may be mutually inconsistent
+             * if the counters are being updated concurrently
+            */
+            [[nodiscard]]
+            auto snapshot () const -> stats
+            {
+                return {
+                    _escape_bytes.load(std::memory_order_relaxed),
+                    _text_bytes.load(std::memory_order_relaxed),
+                    _manipulators.load(std::memory_order_relaxed),
+                    _redundant.load(std::memory_order_relaxed),
+                    _resets.load(std::memory_order_relaxed),
+                };
+            }
+
+            /**
+             * \brief Sets all the counters to zero
+            */
+            void clear ()
+            {
+                for (auto* c : { &_escape_bytes, &_text_bytes, &_manipulators, &_redundant, &_resets })
+                {
+                    c->store(0, std::memory_order_relaxed);
+                }
+            }
+        };
+
+        /**
+         * \brief Returns the process-wide counters
+        */
+        [[nodiscard]]
+        inline auto global () -> counters&
+        {
+            static counters instance;
+            return instance;
+        }
+
+        /**
+         * \brief Returns current values of the process-wide counters
+        */
+        [[nodiscard]]
+        inline auto snapshot () -> stats
+        {
+            return global().snapshot();
+        }
+
+        /**
+         * \internal
+         * \brief Index of the per-stream storage: `iword` holds the last applied state, `pword` — the meter
+        */
+        inline auto _stream_index () -> int
+        {
+            static int const index = std::ios_base::xalloc();
+            return index;
+        }
+
+        /**
+         * \class metered_stream
+         *
+         * \brief Attaches per-stream counters to an output stream for the object lifetime
+         *
+         * \details Substitutes the stream buffer with a pass-through one which counts written
+         * bytes, so that text bytes can be told apart from escape sequences
+        */
+        class metered_stream
+        {
+            class _buffer : public std::streambuf
+            {
+            public:
+
+                std::streambuf* _target;
+                counters* _own;
+                std::size_t _escape_pending = 0;    ///< Bytes of the escape sequence being written
+
+                _buffer (std::streambuf* target, counters* own) : _target{ target }, _own{ own } {}
+
+                void count (std::size_t n)
+                {
+                    auto escape_part = n < _escape_pending ? n : _escape_pending;
+                    _escape_pending -= escape_part;
+
+                    if (auto text = n - escape_part)
+                    {
+                        _own->_text_bytes.fetch_add(text, std::memory_order_relaxed);
+                        global()._text_bytes.fetch_add(text, std::memory_order_relaxed);
+                    }
+                }
+
+            protected:
+
+                auto overflow (int_type ch) -> int_type override
+                {
+                    if (traits_type::eq_int_type(ch, traits_type::eof())) return traits_type::not_eof(ch);
+
+                    auto res = _target->sputc(traits_type::to_char_type(ch));
+                    if (!traits_type::eq_int_type(res, traits_type::eof())) count(1);
+
+                    return res;
+                }
+
+                auto xsputn (char const* str, std::streamsize n) -> std::streamsize override
+                {
+                    auto res = _target->sputn(str, n);
+                    if (res > 0) count((std::size_t)res);
+
+                    return res;
+                }
+
+                auto sync () -> int override
+                {
+                    return _target->pubsync();
+                }
+            };
+
+            std::ostream& _os;
+            counters _counters;
+            _buffer _buf;
+
+        public:
+
+            /**
+             * \brief Starts metering of the output stream
+             *
+             * \param os Output stream
+            */
+            explicit metered_stream (std::ostream& os)
+                : _os{ os }
+                , _buf{ os.rdbuf(), &_counters }
+            {
+                _os.rdbuf(&_buf);
+                _os.pword(_stream_index()) = &_buf;
+            }
+
+            /// Restoring of the stream buffer can happen only once
+            metered_stream (metered_stream const&) = delete;
+            auto operator = (metered_stream const&) -> metered_stream& = delete;
+
+            /**
+             * \brief Destructor. Restores the original stream buffer
+            */
+            ~metered_stream ()
+            {
+                _os.flush();
+                _os.pword(_stream_index()) = nullptr;
+                _os.rdbuf(_buf._target);
+            }
+
+            /**
+             * \brief Returns current values of the stream counters
+            */
+            [[nodiscard]]
+            auto snapshot () const -> stats
+            {
+                return _counters.snapshot();
+            }
+
+            /**
+             * \brief Returns the stream counters
+            */
+            [[nodiscard]]
+            auto get_counters () -> counters&
+            {
+                return _counters;
+            }
+
+            friend void _account (std::ostream&, int, std::size_t, uint32_t);
+        };
+
+        /// \internal Flags of the packed last state
+        enum : uint32_t { _colors_known = 1u << 24, _style_known = 1u << 25 };
+
+        /**
+         * \internal
+         * \brief Accounts a manipulator application just before its escape sequence is written
+         *
+         * \param os Output stream
+         * \param event Kind of the manipulator
+         * \param bytes Size of the escape sequence
+         * \param value Packed colors (`face` | `back` << 8) or style
+        */
+        inline void _account (std::ostream& os, int event, std::size_t bytes, uint32_t value)
+        {
+            auto& last = os.iword(_stream_index());
+            auto prev = (uint32_t)last;
+            auto next = prev;
+
+            switch (event)
+            {
+            case _color_event:
+                next = (prev & ~0xFFFFu) | value | _colors_known;
+                break;
+
+            case _font_event:
+                next = (prev & ~0xFF0000u) | (value << 16) | _style_known;
+                break;
+
+            default:
+                next = _colors_known | _style_known;
+            }
+            last = (long)next;
+
+            auto known = event == _color_event ? _colors_known
+                       : event == _font_event  ? _style_known
+                       : _colors_known | _style_known;
+
+            auto redundant = (prev & known) == known && prev == next;
+
+            auto update = [&] (counters& c)
+            {
+                c._escape_bytes.fetch_add(bytes, std::memory_order_relaxed);
+                c._manipulators.fetch_add(1, std::memory_order_relaxed);
+
+                if (redundant) c._redundant.fetch_add(1, std::memory_order_relaxed);
+                if (event == _reset_event) c._resets.fetch_add(1, std::memory_order_relaxed);
+            };
+            update(global());
+
+            if (auto* meter = static_cast<metered_stream::_buffer*>(os.pword(_stream_index())))
+            {
+                // The escape is counted as text if the buffer was substituted once again
+                if (os.rdbuf() == meter) meter->_escape_pending += bytes;
+                update(*meter->_own);
+            }
+        }
+    }   // end namespace metrics
+#endif
+
+    // SECTION Style commands
+    /// \internal Number of live `styling_streambuf` objects; while zero, streams aren't inspected
+    inline std::atomic<int> _styling_buffers{ 0 };
+
+    /**
+     * \internal
+     * \brief Hands a manipulator application to the `styling_streambuf` of the stream, if any
+     *
+     * \return `false` if the stream doesn't write to such buffer
+    */
+    inline auto _command (std::ostream& os, int event, uint32_t value) -> bool;
+    // !SECTION
 
-        return back{ 60 + (uint8_t)clr };
+    /**
+     * \internal
+     * \brief Writes the escape sequence of a manipulator, accounting it if instrumentation is on
+     *
+     * \param os Output stream
+     * \param seq Escape sequence
+     * \param event Kind of the manipulator (see `metrics::_account`)
+     * \param value Packed manipulator parameters
+    */
+    template <typename Seq>
+    TESC_CONSTEXPR auto _emit (std::ostream& os, [[maybe_unused]] Seq const& seq, [[maybe_unused]] int event, [[maybe_unused]] uint32_t value) -> std::ostream&
+    {
+#ifdef TESC_DISABLE
+        return os;
+#else
+        if (_styling_buffers.load(std::memory_order_relaxed) && _command(os, event, value))
+        {
+#   ifdef TESC_INSTRUMENT
+            metrics::_account(os, event, 0, value);
+#   endif
+            return os;
+        }
+#   ifdef TESC_INSTRUMENT
+        metrics::_account(os, event, seq.size(), value);
+#   endif
+        // Unformatted: a pending field width belongs to the text which follows
+        return os.write(seq.data(), (std::streamsize)seq.size());
+#endif
     }
     // !SECTION
 
@@ -139,8 +692,10 @@ namespace tesc
     */
     class color
     {
-        static face _fg_color;    ///< Foreground color
-        static back _bg_color;    ///< Background color
+        static inline TESC_STATE_STORAGE _slot_t<face> _fg_color{ face::none };    ///< Foreground color
+        static inline TESC_STATE_STORAGE _slot_t<back> _bg_color{ back::none };    ///< Background color
+
+        friend class state;
 
     public:
 
@@ -152,7 +707,7 @@ namespace tesc
          *
          * \param clr ANSI color code
         */
-        color (std::pair<face, back> const& clr)
+        TESC_CONSTEXPR color (std::pair<face, back> const& clr)
         {
             _fg_color = clr.first;
             _bg_color = clr.second;
@@ -163,7 +718,7 @@ namespace tesc
          *
          * \param clr Text foreground color
         */
-        color (face clr)
+        TESC_CONSTEXPR color (face clr)
         {
             _fg_color = clr;
         }
@@ -173,7 +728,7 @@ namespace tesc
          *
          * \param clr Text background color
         */
-        color (back clr)
+        TESC_CONSTEXPR color (back clr)
         {
             _bg_color = clr;
         }
@@ -182,7 +737,7 @@ namespace tesc
          * \brief Getting current text foreground color
         */
         [[nodiscard]]
-        static auto get_face () -> face
+        static TESC_CONSTEXPR auto get_face () -> face
         {
             return _fg_color;
         }
@@ -191,7 +746,7 @@ namespace tesc
          * \brief Getting current text background color
         */
         [[nodiscard]]
-        static auto get_back () -> back
+        static TESC_CONSTEXPR auto get_back () -> back
         {
             return _bg_color;
         }
@@ -204,22 +759,12 @@ namespace tesc
          *
          * \return Reference to the output stream
         */
-        friend auto operator << (std::ostream& os, color const& decorator) -> std::ostream&
+        friend TESC_CONSTEXPR auto operator << (std::ostream& os, color const& decorator) -> std::ostream&
         {
-            int clr_1 = (uint8_t)decorator.get_face(),
-                clr_2 = (uint8_t)decorator.get_back();
-
-            os << "\033[";
-
-            // Zero-valued colors don't have any effect
-            if (clr_1)
-            {
-                os << clr_1;
-                if (clr_2) os << ";";
-            }
-            if (clr_2) os << clr_2;
+            auto fg = decorator.get_face();
+            auto bg = decorator.get_back();
 
-            return os << "m";
+            return _emit(os, to_escape(fg, bg), _color_event, (uint32_t)fg | (uint32_t)bg << 8);
         }
     };
 
@@ -231,7 +776,9 @@ namespace tesc
     */
     class font
     {
-        static style _style;
+        static inline TESC_STATE_STORAGE _slot_t<style> _style{ style::normal };
+
+        friend class state;
 
     public:
 
@@ -245,7 +792,7 @@ namespace tesc
          *
          * \param st Font style
         */
-        font (style st)
+        TESC_CONSTEXPR font (style st)
         {
             _style = st;
         }
@@ -258,30 +805,18 @@ namespace tesc
          *
          * \return Reference to the output stream
         */
-        friend auto operator << (std::ostream& os, font const& styler) -> std::ostream&
+        friend TESC_CONSTEXPR auto operator << (std::ostream& os, font const& styler) -> std::ostream&
         {
-            int modif[] = {
-                test_style(style::bold) ? 1 : 22,
-                test_style(style::italic) ? 3 : 23,
-                test_style(style::underline) ? 4 : 24,
-            };
+            auto st = (uint8_t)styler.get_style() & 7;
 
-            // Sorting an array due to cancellers which must be the last
-            if (modif[0] > modif[1]) std::swap(modif[0], modif[1]);
-            if (modif[1] > modif[2])
-            {
-                std::swap(modif[1], modif[2]);
-                if (modif[0] > modif[1]) std::swap(modif[0], modif[1]);
-            }
-
-            return os << "\033[" << modif[0] << ";" << modif[1] << ";" << modif[2] << "m";
+            return _emit(os, _style_escapes[st], _font_event, st);
         }
 
         /**
          * \brief Returns current font style
         */
         [[nodiscard]]
-        static auto get_style () -> style
+        static TESC_CONSTEXPR auto get_style () -> style
         {
             return _style;
         }
@@ -293,7 +828,7 @@ namespace tesc
          * \param st Style option
         */
         [[nodiscard]]
-        static auto test_style (style stl) -> bool
+        static TESC_CONSTEXPR auto test_style (style stl) -> bool
         {
             if (
                 auto st_1 = (uint8_t)get_style(), st_2 = (uint8_t)stl;
@@ -313,16 +848,651 @@ namespace tesc
      *
      * \return Reference to the output stream
     */
-    auto reset (std::ostream& os) -> std::ostream&
+    TESC_CONSTEXPR auto reset (std::ostream& os) -> std::ostream&
     {
-        return os << "\033[0m";
+        return _emit(os, reset_escape, _reset_event, 0);
     }
-    // !SECTION
 
-    // Static fields initialization
-    face color::_fg_color = face::none;
-    back color::_bg_color = back::none;
-    style font::_style = style::normal;
+    // ANCHOR Settings snapshots
+    /**
+     * \class state
+     *
+     * \brief Packed snapshot of the `color` and `font` settings
+     *
+     * \details Allows to carry the settings between threads (e.g. along with a task
+     * in a thread pool) when they are `thread_local` (see `TESC_THREAD_LOCAL`)
+    */
+    class state
+    {
+        uint32_t _packed;    ///< `face` | `back` << 8 | `style` << 16
+
+    public:
+
+        /**
+         * \brief Constructs the state from its components
+         *
+         * \param fg Text foreground color
+         * \param bg Text background color
+         * \param st Font style
+        */
+        constexpr state (face fg = face::none, back bg = back::none, style st = style::normal)
+            : _packed{ (uint32_t)fg | (uint32_t)bg << 8 | (uint32_t)st << 16 }
+        {}
+
+        /**
+         * \brief Takes a snapshot of the current settings (of the calling thread)
+        */
+        [[nodiscard]]
+        static TESC_CONSTEXPR auto current () -> state
+        {
+            return { color::get_face(), color::get_back(), font::get_style() };
+        }
+
+        /**
+         * \brief Makes the snapshot current settings (of the calling thread) without any output
+        */
+        TESC_CONSTEXPR void restore () const
+        {
+            color::_fg_color = get_face();
+            color::_bg_color = get_back();
+            font::_style = get_style();
+        }
+
+        /**
+         * \brief Returns the stored text foreground color
+        */
+        [[nodiscard]]
+        constexpr auto get_face () const -> face
+        {
+            return face{ (uint8_t)_packed };
+        }
+
+        /**
+         * \brief Returns the stored text background color
+        */
+        [[nodiscard]]
+        constexpr auto get_back () const -> back
+        {
+            return back{ (uint8_t)(_packed >> 8) };
+        }
+
+        /**
+         * \brief Returns the stored font style
+        */
+        [[nodiscard]]
+        constexpr auto get_style () const -> style
+        {
+            return style{ (uint8_t)(_packed >> 16) };
+        }
+
+        /**
+         * \brief Returns the packed representation of the state
+        */
+        [[nodiscard]]
+        constexpr auto packed () const -> uint32_t
+        {
+            return _packed;
+        }
+
+        /**
+         * \brief Equality operator
+        */
+        [[nodiscard]]
+        friend constexpr auto operator == (state const& lhs, state const& rhs) -> bool
+        {
+            return lhs._packed == rhs._packed;
+        }
+
+        /**
+         * \brief Inequality operator
+        */
+        [[nodiscard]]
+        friend constexpr auto operator != (state const& lhs, state const& rhs) -> bool
+        {
+            return !(lhs == rhs);
+        }
+
+        /**
+         * \brief Restores the settings and applies them to the output stream
+         *
+         * \param os Output stream
+         * \param st Settings snapshot
+         *
+         * \return Reference to the output stream
+        */
+        friend TESC_CONSTEXPR auto operator << (std::ostream& os, state const& st) -> std::ostream&
+        {
+            st.restore();
+            return os << color{ st.get_face() | st.get_back() } << font{ st.get_style() };
+        }
+    };
+
+    /**
+     * \brief Builds the shortest sequence which changes the `from` settings into the `to` ones
+     *
+     * \details Unlike the manipulators, resets the colors to the defaults (codes 39, 49) when
+     * they are `none`, and touches only the changed style attributes. Prefers the full reset
+     * when the target is the default state and it is shorter
+     *
+     * \param from Current settings of the terminal
+     * \param to Desired settings
+     *
+     * \return Escape sequence (empty if the settings are equal)
+    */
+    [[nodiscard]]
+    constexpr auto transition (state from, state to) -> escape
+    {
+        escape seq;
+        if (from == to) return seq;
+
+        auto params = 0;
+        auto param = [&] (unsigned code) {
+            seq.push(params++ ? ';' : '[').push(code);
+        };
+        seq.push('\033');
+
+        if (from.get_face() != to.get_face())
+        {
+            param(to.get_face() == face::none ? 39u : (unsigned)to.get_face());
+        }
+        if (from.get_back() != to.get_back())
+        {
+            param(to.get_back() == back::none ? 49u : (unsigned)to.get_back());
+        }
+
+        constexpr unsigned on[] = { 1, 3, 4 }, off[] = { 22, 23, 24 };
+
+        for (auto i = 0; i < 3; ++i)
+        {
+            auto bit = 1u << i;
+            auto was = (uint8_t)from.get_style() & bit, now = (uint8_t)to.get_style() & bit;
+            if (was != now) param(now ? on[i] : off[i]);
+        }
+        seq.push('m');
+
+        if (to == state{} && seq.size() > reset_escape.size())
+        {
+            seq = {};
+            for (auto ch : reset_escape) seq.push(ch);
+        }
+        return seq;
+    }
+
+    /**
+     * \class state_guard
+     *
+     * \brief Restores the settings (of the calling thread) on scope exit
+    */
+    class state_guard
+    {
+        state _saved;
+
+    public:
+
+        /**
+         * \brief Takes a snapshot of the current settings
+        */
+        TESC_CONSTEXPR state_guard ()
+            : _saved{ state::current() }
+        {}
+
+        /// Single restoration per snapshot
+        state_guard (state_guard const&) = delete;
+        auto operator = (state_guard const&) -> state_guard& = delete;
+
+        /**
+         * \brief Destructor. Restores the snapshot without any output
+        */
+        ~state_guard ()
+        {
+            _saved.restore();
+        }
+
+        /**
+         * \brief Returns the snapshot taken at construction
+        */
+        [[nodiscard]]
+        constexpr auto saved () const -> state
+        {
+            return _saved;
+        }
+    };
+    // !SECTION
+
+    // SECTION Deferred styling
+    /**
+     * \class styling_streambuf
+     *
+     * \brief Stream buffer which takes the manipulators as style commands instead of bytes
+     *
+     * \details Manipulators written to a stream with this buffer only change the desired state.
+     * The shortest transition to it (see `transition()`) is emitted just before the next text,
+     * so successive changes collapse into a single sequence, and the ones not followed by any
+     * text cost nothing. The bytes reach the target buffer by large blocks and on flushes
+     *
+     * \note Escape sequences written as text (not by the manipulators) aren't tracked. The
+     * pending change is written on destruction only, not on flushes
+    */
+    class styling_streambuf : public std::streambuf
+    {
+        static constexpr std::size_t _capacity = 8192;
+
+        std::streambuf* _target;
+        state _actual;                          ///< State of the terminal
+        state _desired;                         ///< State requested by the manipulators
+        char _area[_capacity];
+
+        friend auto _command (std::ostream&, int, uint32_t) -> bool;
+
+    public:
+
+        /**
+         * \brief Constructs the buffer over the target one
+         *
+         * \param target Stream buffer to write to
+         * \param initial Settings of the terminal at the start
+        */
+        explicit styling_streambuf (std::streambuf* target, state initial = {})
+            : _target{ target }
+            , _actual{ initial }
+            , _desired{ initial }
+        {
+            setp(_area, _area + _capacity);
+            _styling_buffers.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /// The put area refers to the object
+        styling_streambuf (styling_streambuf const&) = delete;
+        auto operator = (styling_streambuf const&) -> styling_streambuf& = delete;
+
+        /**
+         * \brief Destructor. Writes the pending change and the buffered bytes
+        */
+        ~styling_streambuf () override
+        {
+            _apply();
+            _drain();
+            _target->pubsync();
+
+            _styling_buffers.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        /**
+         * \brief Returns the settings requested by the manipulators
+        */
+        [[nodiscard]]
+        auto desired () const -> state
+        {
+            return _desired;
+        }
+
+    protected:
+
+        auto overflow (int_type ch) -> int_type override
+        {
+            if (!_apply()) return traits_type::eof();
+            if (traits_type::eq_int_type(ch, traits_type::eof())) return traits_type::not_eof(ch);
+
+            if (pptr() == epptr() && !_drain()) return traits_type::eof();
+
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+
+            return ch;
+        }
+
+        auto xsputn (char const* str, std::streamsize n) -> std::streamsize override
+        {
+            if (!_apply()) return 0;
+
+            if (n <= epptr() - pptr())
+            {
+                traits_type::copy(pptr(), str, (std::size_t)n);
+                pbump((int)n);
+
+                return n;
+            }
+            // Large writes bypass the buffer
+            if (!_drain()) return 0;
+            if (n < (std::streamsize)_capacity) return xsputn(str, n);
+
+            return _target->sputn(str, n);
+        }
+
+        auto sync () -> int override
+        {
+            return _drain() ? _target->pubsync() : -1;
+        }
+
+    private:
+
+        /**
+         * \brief Changes the desired state like the manipulator does on a terminal
+        */
+        void _change (int event, uint32_t value)
+        {
+            auto fg = _desired.get_face();
+            auto bg = _desired.get_back();
+            auto st = _desired.get_style();
+
+            switch (event)
+            {
+            case _color_event:
+                // Zero-valued colors don't have any effect, but both of them make a full reset
+                if (!value) fg = face::none, bg = back::none, st = style::normal;
+                if ((uint8_t)value) fg = face{ (uint8_t)value };
+                if ((uint8_t)(value >> 8)) bg = back{ (uint8_t)(value >> 8) };
+                break;
+
+            case _font_event:
+                st = style{ (uint8_t)value };
+                break;
+
+            default:
+                fg = face::none, bg = back::none, st = style::normal;
+            }
+            _desired = { fg, bg, st };
+
+            // Until the change is written, the next byte goes through `overflow`
+            auto used = (int)(pptr() - pbase());
+            setp(_area, _desired == _actual ? _area + _capacity : pptr());
+            pbump(used);
+        }
+
+        /**
+         * \brief Writes the pending change into the buffer
+        */
+        auto _apply () -> bool
+        {
+            if (_desired == _actual) return true;
+
+            auto seq = transition(_actual, _desired);
+            auto used = (std::size_t)(pptr() - pbase());
+
+            if (used + seq.size() > _capacity)
+            {
+                setp(_area, _area + _capacity);
+                pbump((int)used);
+
+                if (!_drain()) return false;
+                used = 0;
+            }
+            traits_type::copy(_area + used, seq.data(), seq.size());
+
+            setp(_area, _area + _capacity);
+            pbump((int)(used + seq.size()));
+
+            _actual = _desired;
+            return true;
+        }
+
+        /**
+         * \brief Passes the buffered bytes to the target buffer
+        */
+        auto _drain () -> bool
+        {
+            auto n = pptr() - pbase();
+            auto res = n ? _target->sputn(pbase(), n) : 0;
+
+            // A pending change keeps the put area closed
+            setp(_area, _desired == _actual ? _area + _capacity : _area);
+            return res == n;
+        }
+    };
+
+    inline auto _command (std::ostream& os, int event, uint32_t value) -> bool
+    {
+        auto* buf = dynamic_cast<styling_streambuf*>(os.rdbuf());
+        if (!buf) return false;
+
+        buf->_change(event, value);
+        return true;
+    }
+    // !SECTION
+
+#ifdef TESC_DISABLE
+    // Disabled manipulators must stay constant expressions, i.e. never touch the static state
+    static_assert(
+        (color{ face::red | back::blue }, color{ face::red }, color{ back::blue }, font{ style::bold }, true)
+        && color::get_face() == face::none && font::get_style() == style::normal
+    );
+#endif
+
+#if TESC_HAS_POSIX
+    // SECTION Signal-safe output
+    /**
+     * \class emergency
+     *
+     * \brief Async-signal-safe stylized writer for crash handlers
+     *
+     * \details Accumulates text and escape sequences in an on-stack buffer and passes them
+     * directly to `write(2)`. Neither allocates nor locks, and never touches the shared state
+     * of the `color` and `font` manipulators: the current colors and style are tracked locally
+     *
+     * \note Must be constructed on the stack of the handler itself
+    */
+    class emergency
+    {
+        static constexpr std::size_t _capacity = 512;
+
+        char _buffer[_capacity];
+        std::size_t _size = 0;
+        int _fd;
+
+        face _fg_color = face::none;    ///< Foreground color
+        back _bg_color = back::none;    ///< Background color
+
+    public:
+
+        /**
+         * \brief Constructs the writer over a file descriptor
+         *
+         * \param fd Target file descriptor (`stderr` by default)
+        */
+        explicit emergency (int fd = STDERR_FILENO) noexcept
+            : _fd{ fd }
+        {}
+
+        /// Copying would duplicate the buffered bytes
+        emergency (emergency const&) = delete;
+        auto operator = (emergency const&) -> emergency& = delete;
+
+        /**
+         * \brief Destructor. Flushes the remaining bytes
+        */
+        ~emergency ()
+        {
+            flush();
+        }
+
+        /**
+         * \brief Writes the buffered bytes to the file descriptor
+         *
+         * \return `false` if the descriptor refused to accept them
+        */
+        auto flush () noexcept -> bool
+        {
+            auto saved_errno = errno;
+            auto ok = true;
+
+            for (std::size_t done = 0; done < _size;)
+            {
+                auto n = ::write(_fd, _buffer + done, _size - done);
+
+                if (n > 0) done += (std::size_t)n;
+                else if (n < 0 && errno == EINTR) continue;
+                else { ok = false; break; }
+            }
+            _size = 0;
+
+            // The handler must leave `errno` of the interrupted code untouched
+            errno = saved_errno;
+            return ok;
+        }
+
+        /**
+         * \brief Appends raw bytes
+         *
+         * \param data Bytes to append
+         * \param count Number of bytes
+         *
+         * \return Reference to the writer itself
+        */
+        auto write (char const* data, std::size_t count) noexcept -> emergency&
+        {
+            while (count)
+            {
+                if (_size == _capacity) flush();
+
+                auto n = count < _capacity - _size ? count : _capacity - _size;
+                for (std::size_t i = 0; i < n; ++i) _buffer[_size + i] = data[i];
+
+                _size += n, data += n, count -= n;
+            }
+            return *this;
+        }
+
+        /**
+         * \brief Appends a string
+        */
+        auto operator << (std::string_view str) noexcept -> emergency&
+        {
+            return write(str.data(), str.size());
+        }
+
+        /**
+         * \brief Appends a null-terminated string
+        */
+        auto operator << (char const* str) noexcept -> emergency&
+        {
+            return *this << std::string_view{ str ? str : "(null)" };
+        }
+
+        /**
+         * \brief Appends a single character
+        */
+        auto operator << (char ch) noexcept -> emergency&
+        {
+            return write(&ch, 1);
+        }
+
+        /**
+         * \brief Appends a decimal representation of an integer
+        */
+        template <typename Int, typename = std::enable_if_t<std::is_integral_v<Int>>>
+        auto operator << (Int value) noexcept -> emergency&
+        {
+            char digits[24];
+            int n = 0;
+
+            auto magnitude = (std::make_unsigned_t<Int>)value;
+            if constexpr (std::is_signed_v<Int>)
+            {
+                if (value < 0) magnitude = (std::make_unsigned_t<Int>)(0 - magnitude);
+            }
+
+            do digits[n++] = char('0' + magnitude % 10); while (magnitude /= 10);
+
+            if constexpr (std::is_signed_v<Int>)
+            {
+                if (value < 0) digits[n++] = '-';
+            }
+            while (n) *this << digits[--n];
+
+            return *this;
+        }
+
+        /**
+         * \brief Appends a hexadecimal representation of an address (e.g. a stack frame)
+        */
+        auto operator << (void const* ptr) noexcept -> emergency&
+        {
+            auto value = (uintptr_t)ptr;
+            char digits[2 * sizeof value];
+            int n = 0;
+
+            do digits[n++] = "0123456789abcdef"[value & 0xF]; while (value >>= 4);
+
+            *this << "0x";
+            while (n) *this << digits[--n];
+
+            return *this;
+        }
+
+        /**
+         * \brief Appends a prepared escape sequence as-is
+        */
+        auto operator << (escape const& seq) noexcept -> emergency&
+        {
+            return write(seq.data(), seq.size());
+        }
+
+        /**
+         * \brief Changes colors like `color{ clr }` does
+        */
+        auto operator << (std::pair<face, back> const& clr) noexcept -> emergency&
+        {
+            if constexpr (!enabled) return *this;
+
+            _fg_color = clr.first;
+            _bg_color = clr.second;
+
+            return *this << to_escape(_fg_color, _bg_color);
+        }
+
+        /**
+         * \brief Changes the foreground color like `color{ clr }` does
+        */
+        auto operator << (face clr) noexcept -> emergency&
+        {
+            return *this << (clr | _bg_color);
+        }
+
+        /**
+         * \brief Changes the background color like `color{ clr }` does
+        */
+        auto operator << (back clr) noexcept -> emergency&
+        {
+            return *this << (_fg_color | clr);
+        }
+
+        /**
+         * \brief Changes the font style like `font{ st }` does
+        */
+        auto operator << (style st) noexcept -> emergency&
+        {
+            if constexpr (!enabled) return *this;
+
+            return *this << _style_escapes[(uint8_t)st & 7];
+        }
+
+        /**
+         * \brief Applies a stream manipulator
+         *
+         * \details Understands `tesc::reset`, `std::endl` and `std::flush`; ignores others
+        */
+        auto operator << (std::ostream& (*manip)(std::ostream&)) noexcept -> emergency&
+        {
+            using manip_t = std::ostream& (*)(std::ostream&);
+
+            if (manip == reset)
+            {
+                _fg_color = face::none;
+                _bg_color = back::none;
+
+                return enabled ? *this << reset_escape : *this;
+            }
+            if (manip == static_cast<manip_t>(std::endl)) *this << '\n';
+
+            if (manip == static_cast<manip_t>(std::endl) || manip == static_cast<manip_t>(std::flush))
+            {
+                flush();
+            }
+            return *this;
+        }
+    };
+    // !SECTION
+#endif
 
 }   // end namespace tesc
 
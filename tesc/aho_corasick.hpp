@@ -0,0 +1,203 @@
+#pragma once
+
+// Copyright © 2020-2021 Alex Qzminsky.
+// License: MIT. All rights reserved.
+
+/// \brief Aho-Corasick multi-pattern literal matcher
+///
+/// \author https://github.com/qzminsky
+
+#ifndef TESC_AHO_CORASICK_H
+#define TESC_AHO_CORASICK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <string_view>
+#include <vector>
+
+namespace tesc
+{
+    /**
+     * \class literal_set
+     *
+     * \brief Set of literal patterns matched simultaneously in a single pass
+     *
+     * \details The automaton is built with all the transitions resolved, so scanning costs
+     * a single table lookup per input byte regardless of the number of patterns
+    */
+    class literal_set
+    {
+        static constexpr int32_t _none = -1;
+
+        std::vector<int32_t> _trie;         ///< Patterns trie: state * 256 + byte
+        std::vector<int32_t> _next;         ///< Resolved transitions: state * 256 + byte
+        std::vector<int32_t> _fail;         ///< Failure links
+        std::vector<int32_t> _terminal;     ///< First pattern ending in the state
+        std::vector<int32_t> _dict;         ///< Nearest state with patterns on the suffix chain
+        std::vector<int32_t> _same;         ///< Next pattern ending in the same state
+        std::vector<uint32_t> _lengths;     ///< Pattern lengths
+        bool _built = false;
+
+    public:
+
+        /**
+         * \brief Constructs an empty set
+        */
+        literal_set ()
+        {
+            _add_state();
+        }
+
+        /**
+         * \brief Adds a pattern. Invalidates the automaton until the next `build()`
+         *
+         * \param pattern Non-empty literal
+         *
+         * \return Pattern identifier (sequential, starting from zero)
+        */
+        auto add (std::string_view pattern) -> std::size_t
+        {
+            int32_t state = 0;
+
+            for (auto ch : pattern)
+            {
+                auto slot = (std::size_t)state * 256 + (uint8_t)ch;
+                if (_trie[slot] == _none) _trie[slot] = _add_state();
+
+                state = _trie[slot];
+            }
+
+            auto id = (int32_t)_lengths.size();
+
+            _lengths.push_back((uint32_t)pattern.size());
+            _same.push_back(_terminal[(std::size_t)state]);
+            _terminal[(std::size_t)state] = id;
+            _built = false;
+
+            return (std::size_t)id;
+        }
+
+        /**
+         * \brief Returns the number of patterns
+        */
+        [[nodiscard]]
+        auto size () const -> std::size_t
+        {
+            return _lengths.size();
+        }
+
+        /**
+         * \brief Resolves failure links into the complete transitions table
+        */
+        void build ()
+        {
+            std::queue<int32_t> queue;
+
+            _next = _trie;
+            _fail.assign(_terminal.size(), 0);
+            _dict.assign(_terminal.size(), _none);
+
+            // The root transitions which don't continue any pattern lead back to the root
+            for (auto ch = 0; ch < 256; ++ch)
+            {
+                auto& next = _next[(std::size_t)ch];
+
+                if (next != _none) queue.push(next);
+                else next = 0;
+            }
+
+            while (!queue.empty())
+            {
+                auto state = queue.front();
+                queue.pop();
+
+                auto fail = _fail[(std::size_t)state];
+                _dict[(std::size_t)state] = _terminal[(std::size_t)fail] != _none ? fail : _dict[(std::size_t)fail];
+
+                for (auto ch = 0; ch < 256; ++ch)
+                {
+                    auto& next = _next[(std::size_t)state * 256 + (std::size_t)ch];
+                    auto fallback = _next[(std::size_t)fail * 256 + (std::size_t)ch];
+
+                    if (next != _none)
+                    {
+                        _fail[(std::size_t)next] = fallback;
+                        queue.push(next);
+                    }
+                    else next = fallback;
+                }
+            }
+            _built = true;
+        }
+
+        /**
+         * \brief Reports all (possibly overlapping) occurrences of the patterns
+         *
+         * \param text Input text
+         * \param on_match Callback `(std::size_t id, std::size_t begin, std::size_t end)`
+         *
+         * \note Requires `build()` after the last `add()`
+        */
+        template <typename Callback>
+        void scan (std::string_view text, Callback&& on_match) const
+        {
+            if (!_built || _lengths.empty()) return;
+
+            int32_t state = 0;
+            auto const* table = _next.data();
+
+            for (std::size_t i = 0; i < text.size(); ++i)
+            {
+                state = table[(std::size_t)state * 256 + (uint8_t)text[i]];
+
+                auto hit = _terminal[(std::size_t)state] != _none ? state : _dict[(std::size_t)state];
+
+                for (; hit != _none; hit = _dict[(std::size_t)hit])
+                {
+                    for (auto id = _terminal[(std::size_t)hit]; id != _none; id = _same[(std::size_t)id])
+                    {
+                        on_match((std::size_t)id, i + 1 - _lengths[(std::size_t)id], i + 1);
+                    }
+                }
+            }
+        }
+
+    private:
+
+        auto _add_state () -> int32_t
+        {
+            auto id = (int32_t)_terminal.size();
+
+            _trie.resize(_trie.size() + 256, _none);
+            _terminal.push_back(_none);
+
+            return id;
+        }
+    };
+
+}   // end namespace tesc
+
+#endif  // TESC_AHO_CORASICK_H
+
+// MIT License
+//
+// Copyright (c) 2020-2021 Alex Qzminsky
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
@@ -0,0 +1,272 @@
+#pragma once
+
+// Copyright © 2020-2021 Alex Qzminsky.
+// License: MIT. All rights reserved.
+
+/// \brief Stripping and conversion of escape sequences in captured output
+///
+/// \author https://github.com/qzminsky
+
+#ifndef TESC_ANSI_H
+#define TESC_ANSI_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace tesc
+{
+    /**
+     * \brief Returns the length of the escape sequence which starts at the position
+     *
+     * \details Recognizes CSI sequences (`ESC [ params intermediates final`), the string ones
+     * (OSC, DCS, SOS, PM, APC; terminated by `BEL` or `ESC \`) and the other `ESC`-prefixed ones.
+     * A CSI sequence interrupted by an unexpected byte ends before it
+     *
+     * \param text Input text
+     * \param pos Position of an `ESC` byte
+     *
+     * \return Length in bytes, or `std::string_view::npos` if the text ends inside the sequence
+    */
+    [[nodiscard]]
+    inline auto sequence_length (std::string_view text, std::size_t pos) -> std::size_t
+    {
+        auto const npos = std::string_view::npos;
+        auto i = pos + 1;
+
+        if (i == text.size()) return npos;
+
+        switch (text[i++])
+        {
+        case '[':
+            for (; i < text.size(); ++i)
+            {
+                auto ch = (uint8_t)text[i];
+
+                if (ch >= 0x40 && ch <= 0x7E) return i + 1 - pos;
+                if (ch < 0x20 || ch > 0x3F) return i - pos;
+            }
+            return npos;
+
+        case ']': case 'P': case 'X': case '^': case '_':
+            for (; i < text.size(); ++i)
+            {
+                if (text[i] == '\a') return i + 1 - pos;
+                if (text[i] == '\033')
+                {
+                    if (i + 1 == text.size()) return npos;
+                    return (text[i + 1] == '\\' ? i + 2 : i) - pos;
+                }
+            }
+            return npos;
+
+        default:
+            // Intermediate bytes and the final one
+            for (--i; i < text.size(); ++i)
+            {
+                auto ch = (uint8_t)text[i];
+
+                if (ch < 0x20 || ch > 0x2F) return (ch >= 0x30 && ch <= 0x7E ? i + 1 : i) - pos;
+            }
+            return npos;
+        }
+    }
+
+    /**
+     * \brief Appends the text without escape sequences to the buffer
+     *
+     * \param text Input text
+     * \param out Output buffer
+    */
+    inline void strip_escapes (std::string_view text, std::string& out)
+    {
+        for (std::size_t pos = 0; pos < text.size();)
+        {
+            auto const* esc = (char const*)std::memchr(text.data() + pos, '\033', text.size() - pos);
+            auto start = esc ? (std::size_t)(esc - text.data()) : text.size();
+
+            out.append(text.data() + pos, start - pos);
+            if (!esc) return;
+
+            auto len = sequence_length(text, start);
+            if (len == std::string_view::npos) return;
+
+            pos = start + len;
+        }
+    }
+
+    /**
+     * \brief Appends the text with SGR (styles and colors) sequences only to the buffer
+     *
+     * \details Cursor movements, screen clearing, titles etc. are removed, so that a captured
+     * console session turns into a colored plain log
+     *
+     * \param text Input text
+     * \param out Output buffer
+    */
+    inline void keep_sgr (std::string_view text, std::string& out)
+    {
+        for (std::size_t pos = 0; pos < text.size();)
+        {
+            auto const* esc = (char const*)std::memchr(text.data() + pos, '\033', text.size() - pos);
+            auto start = esc ? (std::size_t)(esc - text.data()) : text.size();
+
+            out.append(text.data() + pos, start - pos);
+            if (!esc) return;
+
+            auto len = sequence_length(text, start);
+            if (len == std::string_view::npos) return;
+
+            if (len > 2 && text[start + 1] == '[' && text[start + len - 1] == 'm')
+            {
+                out.append(text.data() + start, len);
+            }
+            pos = start + len;
+        }
+    }
+
+    /**
+     * \brief Returns the nearest position not inside an escape sequence (and preferably
+     * after a line break) at or after the given one
+     *
+     * \param text Input text
+     * \param pos Desired position
+    */
+    [[nodiscard]]
+    inline auto safe_split (std::string_view text, std::size_t pos) -> std::size_t
+    {
+        // Sequences longer than this one (e.g. huge OSC strings) may be split
+        constexpr std::size_t window = 4096;
+
+        if (pos >= text.size()) return text.size();
+
+        auto const* eol = (char const*)std::memchr(text.data() + pos, '\n', std::min(window, text.size() - pos));
+        auto split = eol ? (std::size_t)(eol - text.data()) + 1 : pos;
+
+        // Even a line break may be inside a string sequence (e.g. an unterminated OSC): looking
+        // for the last sequence start before the split. Any sequence ends at an `ESC`, so the
+        // earlier ones end before that start
+        auto from = split > window ? split - window : 0;
+        auto last = text.substr(from, split - from).rfind('\033');
+
+        if (last != std::string_view::npos)
+        {
+            auto start = from + last;
+            auto len = sequence_length(text, start);
+
+            if (len == std::string_view::npos) return text.size();
+            if (start + len > split) return start + len;
+        }
+        return split;
+    }
+
+    /**
+     * \brief Converts the text by chunks on a pool of threads, passing the results in order
+     *
+     * \details The text is split into chunks of approximately the given size by `safe_split()`.
+     * Workers convert the chunks into their own buffers, and the calling thread passes the
+     * ready buffers to the sink in the original order. At most two chunks per thread are in
+     * flight, so the memory usage doesn't depend on the text size
+     *
+     * \param text Input text (e.g. a mapped file)
+     * \param convert Callable object `(std::string_view chunk, std::string& out)`,
+     * e.g. `strip_escapes`, invoked concurrently
+     * \param sink Callable object `(std::string_view converted)`
+     * \param threads Number of worker threads (0 stands for the hardware concurrency)
+     * \param chunk_size Approximate chunk size in bytes
+    */
+    template <typename Converter, typename Sink>
+    void convert_parallel (std::string_view text, Converter&& convert, Sink&& sink,
+                           unsigned threads = 0, std::size_t chunk_size = std::size_t{ 4 } << 20)
+    {
+        if (!threads) threads = std::max(1u, std::thread::hardware_concurrency());
+        chunk_size = std::max(chunk_size, std::size_t{ 1 });
+
+        std::vector<std::size_t> bounds{ 0 };
+        while (bounds.back() < text.size()) bounds.push_back(safe_split(text, bounds.back() + chunk_size));
+
+        auto const chunks = bounds.size() - 1;
+        auto const slots = 2 * (std::size_t)threads;
+
+        std::vector<std::string> buffers(slots);
+        std::vector<char> ready(slots, false);
+        std::size_t written = 0;
+
+        std::mutex mutex;
+        std::condition_variable converted, released;
+        std::atomic<std::size_t> next{ 0 };
+
+        auto work = [&]
+        {
+            for (std::size_t i; (i = next++) < chunks;)
+            {
+                auto& out = buffers[i % slots];
+                {
+                    // Waiting for the previous owner of the slot to be written
+                    std::unique_lock lock{ mutex };
+                    released.wait(lock, [&] { return i < written + slots; });
+                }
+                out.clear();
+                convert(text.substr(bounds[i], bounds[i + 1] - bounds[i]), out);
+                {
+                    std::lock_guard lock{ mutex };
+                    ready[i % slots] = true;
+                }
+                converted.notify_one();
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (auto t = std::min((std::size_t)threads, chunks); t--;) pool.emplace_back(work);
+
+        for (std::size_t i = 0; i < chunks; ++i)
+        {
+            {
+                std::unique_lock lock{ mutex };
+                converted.wait(lock, [&] { return ready[i % slots]; });
+            }
+            sink(std::string_view{ buffers[i % slots] });
+            {
+                std::lock_guard lock{ mutex };
+
+                ready[i % slots] = false;
+                written = i + 1;
+            }
+            released.notify_all();
+        }
+
+        for (auto& t : pool) t.join();
+    }
+
+}   // end namespace tesc
+
+#endif  // TESC_ANSI_H
+
+// MIT License
+//
+// Copyright (c) 2020-2021 Alex Qzminsky
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
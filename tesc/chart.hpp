@@ -0,0 +1,380 @@
+#pragma once
+
+// Copyright © 2020-2021 Alex Qzminsky.
+// License: MIT. All rights reserved.
+
+/// \brief Sparklines, bar charts and histograms of numeric series
+///
+/// \author https://github.com/qzminsky
+
+#ifndef TESC_CHART_H
+#define TESC_CHART_H
+
+#include "../tesc.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace tesc
+{
+    /**
+     * \struct threshold
+     *
+     * \brief Color of the values starting from the given one
+    */
+    struct threshold
+    {
+        double from;
+        face color;
+    };
+
+    /**
+     * \class chart
+     *
+     * \brief Renderer of numeric series into block characters
+     *
+     * \details The range of a series is found in the same pass which downsamples it: a series
+     * longer than the chart is split into buckets of their minimums and maximums, so the rest of
+     * the rendering depends on the width only. Cells are colored by the thresholds, and the color
+     * sequence is written only where it changes. Everything is appended to a single buffer
+     *
+     * \note NaN values are skipped; labels are expected to be single-byte (ASCII) strings
+    */
+    class chart
+    {
+        std::vector<threshold> _thresholds;     ///< Sorted by `from`
+        double _lo = 0, _hi = 0;
+        bool _fixed_range = false;
+
+        /// Minimum and maximum of a bucket
+        struct _bucket
+        {
+            double lo, hi;
+        };
+
+    public:
+
+        /**
+         * \brief Sets the colors of the values
+         *
+         * \param thresholds A value gets the color of the greatest threshold which is not
+         * greater than the value; values below all of them have the default color
+         *
+         * \return Reference to the chart itself
+        */
+        auto set_thresholds (std::vector<threshold> thresholds) -> chart&
+        {
+            std::sort(thresholds.begin(), thresholds.end(), [] (auto& a, auto& b) { return a.from < b.from; });
+            _thresholds = std::move(thresholds);
+
+            return *this;
+        }
+
+        /**
+         * \brief Fixes the range of the values instead of taking it from the series
+         *
+         * \return Reference to the chart itself
+        */
+        auto set_range (double lo, double hi) -> chart&
+        {
+            _lo = lo, _hi = hi;
+            _fixed_range = true;
+
+            return *this;
+        }
+
+        /**
+         * \brief Appends a single-line chart: a character of the height `▁` to `█` per value
+         *
+         * \param values Values
+         * \param n Number of values
+         * \param width Maximal number of characters; a longer series is shown by the maximums
+         * of its buckets, so the peaks are kept (0 is for a character per value)
+         * \param out Output buffer
+        */
+        void sparkline (double const* values, std::size_t n, std::size_t width, std::string& out) const
+        {
+            static constexpr std::string_view levels[] = { "▁", "▂", "▃", "▄", "▅", "▆", "▇", "█" };
+
+            auto [lo, hi] = _scan(values, n, width);
+            auto& buckets = _buckets();
+
+            out.reserve(out.size() + buckets.size() * 8);
+            auto pen = face::none;
+
+            for (auto& b : buckets)
+            {
+                if (b.hi != b.hi)
+                {
+                    out += ' ';
+                    continue;
+                }
+                auto t = hi > lo ? (b.hi - lo) / (hi - lo) : 0.0;
+                auto level = (std::size_t)std::clamp(t * 7 + 0.5, 0.0, 7.0);
+
+                _set_pen(out, pen, _color(b.hi));
+                out += levels[level];
+            }
+            _set_pen(out, pen, face::none);
+        }
+
+        /**
+         * \brief Appends a horizontal bar per value, with its label and the value
+         *
+         * \param labels Labels of the bars, `n` of them
+         * \param values Values
+         * \param n Number of values
+         * \param width Number of cells of the longest bar
+         * \param out Output buffer
+         *
+         * \note Bars start at zero; negative values have empty bars
+        */
+        void bars (std::string_view const* labels, double const* values, std::size_t n, std::size_t width, std::string& out) const
+        {
+            static constexpr std::string_view eighths[] = { "", "▏", "▎", "▍", "▌", "▋", "▊", "▉" };
+
+            std::size_t label_width = 0;
+            auto hi = _fixed_range ? _hi : 0.0;
+
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                label_width = std::max(label_width, labels[i].size());
+                if (!_fixed_range && values[i] > hi) hi = values[i];
+            }
+            out.reserve(out.size() + n * (label_width + width * 3 + 32));
+
+            auto pen = face::none;
+
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                auto v = values[i];
+                auto t = hi > 0 && v > 0 ? std::min(v / hi, 1.0) : 0.0;
+                auto length = (std::size_t)(t * (double)width * 8 + 0.5);
+
+                out += labels[i];
+                out.append(label_width - labels[i].size() + 1, ' ');
+
+                if (length)
+                {
+                    _set_pen(out, pen, _color(v));
+                    for (auto k = length / 8; k; --k) out += "█";
+                    out += eighths[length % 8];
+                    _set_pen(out, pen, face::none);
+                }
+
+                out.append(width - length / 8 - (length % 8 != 0) + 1, ' ');
+                _append_number(out, v);
+                out += '\n';
+            }
+        }
+
+        /**
+         * \brief Appends a vertical histogram of the values with a line of the range below
+         *
+         * \param values Values
+         * \param n Number of values
+         * \param bins Number of columns
+         * \param height Number of lines of the columns
+         * \param out Output buffer
+         *
+         * \note Without a fixed range the values are read twice: for the range and for the counts.
+         * The values out of a fixed range are not counted; a column is colored by the middle of its bin
+        */
+        void histogram (double const* values, std::size_t n, std::size_t bins, std::size_t height, std::string& out) const
+        {
+            static constexpr std::string_view levels[] = { " ", "▁", "▂", "▃", "▄", "▅", "▆", "▇", "█" };
+
+            if (!bins || !height) return;
+
+            auto lo = _lo, hi = _hi;
+            if (!_fixed_range)
+            {
+                auto range = _scan(values, n, 1);
+                lo = range.first, hi = range.second;
+            }
+            auto const step = hi > lo ? (hi - lo) / (double)bins : 1.0;
+
+            auto& counts = _counts();
+            counts.assign(bins, 0);
+
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                auto v = values[i];
+                if (!(v >= lo && v <= hi)) continue;
+
+                auto bin = (std::size_t)((v - lo) / step);
+                ++counts[bin < bins ? bin : bins - 1];
+            }
+
+            auto top = *std::max_element(counts.begin(), counts.end());
+
+            // Heights of the columns in eighths of a line; a non-empty bin gets at least one
+            for (auto& c : counts)
+            {
+                c = top ? (c * height * 8 + top - 1) / top : 0;
+            }
+            out.reserve(out.size() + (height + 1) * (bins * 3 + 16));
+
+            auto pen = face::none;
+
+            for (auto row = height; row--;)
+            {
+                for (std::size_t b = 0; b < bins; ++b)
+                {
+                    auto filled = counts[b] > row * 8 ? std::min<std::size_t>(counts[b] - row * 8, 8) : 0;
+
+                    if (filled) _set_pen(out, pen, _color(lo + step * ((double)b + 0.5)));
+                    out += levels[filled];
+                }
+                _set_pen(out, pen, face::none);
+                out += '\n';
+            }
+
+            // Bounds of the range under the first and the last columns
+            char low[32], high[32];
+            auto low_size = (std::size_t)std::snprintf(low, sizeof low, "%g", lo);
+            auto high_size = (std::size_t)std::snprintf(high, sizeof high, "%g", hi);
+
+            out.append(low, low_size);
+            if (low_size + high_size < bins)
+            {
+                out.append(bins - low_size - high_size, ' ');
+                out.append(high, high_size);
+            }
+            out += '\n';
+        }
+
+        /**
+         * \brief Appends a single-line chart of the container values
+        */
+        template <typename Container>
+        void sparkline (Container const& values, std::size_t width, std::string& out) const
+        {
+            sparkline(std::data(values), std::size(values), width, out);
+        }
+
+        /**
+         * \brief Appends a vertical histogram of the container values
+        */
+        template <typename Container>
+        void histogram (Container const& values, std::size_t bins, std::size_t height, std::string& out) const
+        {
+            histogram(std::data(values), std::size(values), bins, height, out);
+        }
+
+    private:
+
+        static auto _buckets () -> std::vector<_bucket>&
+        {
+            static thread_local std::vector<_bucket> buckets;
+            return buckets;
+        }
+
+        static auto _counts () -> std::vector<std::size_t>&
+        {
+            static thread_local std::vector<std::size_t> counts;
+            return counts;
+        }
+
+        /**
+         * \brief Splits the values into buckets and finds the range, in a single pass
+         *
+         * \param width Maximal number of buckets (0 is for a bucket per value)
+         *
+         * \return The fixed range or the range of the values
+        */
+        auto _scan (double const* values, std::size_t n, std::size_t width) const -> std::pair<double, double>
+        {
+            auto const nan = std::numeric_limits<double>::quiet_NaN();
+            auto count = width && n > width ? width : n;
+
+            auto& buckets = _buckets();
+            buckets.assign(count, { nan, nan });
+
+            auto lo = nan, hi = nan;
+
+            for (std::size_t b = 0, i = 0; b < count; ++b)
+            {
+                auto end = (b + 1) * n / count;
+                auto& bucket = buckets[b];
+
+                for (; i < end; ++i)
+                {
+                    auto v = values[i];
+                    if (v != v) continue;
+
+                    // Comparisons with NaN are false, so the first value is always taken
+                    if (!(v >= bucket.lo)) bucket.lo = v;
+                    if (!(v <= bucket.hi)) bucket.hi = v;
+                }
+                if (bucket.lo != bucket.lo) continue;   // Only NaN values in the bucket
+
+                if (!(bucket.lo >= lo)) lo = bucket.lo;
+                if (!(bucket.hi <= hi)) hi = bucket.hi;
+            }
+            if (_fixed_range) return { _lo, _hi };
+
+            return lo == lo ? std::pair{ lo, hi } : std::pair{ 0.0, 0.0 };
+        }
+
+        /// Color of the value by the thresholds
+        auto _color (double value) const -> face
+        {
+            auto clr = face::none;
+
+            for (auto& t : _thresholds)
+            {
+                if (value < t.from) break;
+                clr = t.color;
+            }
+            return clr;
+        }
+
+        static void _set_pen (std::string& out, face& pen, face clr)
+        {
+            if (!enabled || clr == pen) return;
+
+            pen = clr;
+            out += clr == face::none ? std::string_view{ "\033[39m" } : to_escape(clr, back::none).view();
+        }
+
+        static void _append_number (std::string& out, double value)
+        {
+            char text[32];
+            auto size = std::snprintf(text, sizeof text, "%g", value);
+
+            out.append(text, (std::size_t)size);
+        }
+    };
+
+}   // end namespace tesc
+
+#endif  // TESC_CHART_H
+
+// MIT License
+//
+// Copyright (c) 2020-2021 Alex Qzminsky
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
@@ -0,0 +1,480 @@
+#pragma once
+
+// Copyright © 2020-2021 Alex Qzminsky.
+// License: MIT. All rights reserved.
+
+/// \brief Compile-time color math: color spaces, interpolation, blending and contrast
+///
+/// \author https://github.com/qzminsky
+
+#ifndef TESC_COLORMATH_H
+#define TESC_COLORMATH_H
+
+#include "../tesc.hpp"
+
+#include <array>
+#include <limits>
+
+namespace tesc
+{
+    /**
+     * \struct rgb
+     *
+     * \brief 24-bit sRGB color
+    */
+    struct rgb
+    {
+        uint8_t r = 0, g = 0, b = 0;
+
+        /**
+         * \brief Makes the color from its `0xRRGGBB` representation
+        */
+        [[nodiscard]]
+        static constexpr auto from_hex (uint32_t hex) -> rgb
+        {
+            return { (uint8_t)(hex >> 16), (uint8_t)(hex >> 8), (uint8_t)hex };
+        }
+
+        /**
+         * \brief Returns the `0xRRGGBB` representation of the color
+        */
+        [[nodiscard]]
+        constexpr auto hex () const -> uint32_t
+        {
+            return (uint32_t)r << 16 | (uint32_t)g << 8 | b;
+        }
+
+        [[nodiscard]]
+        friend constexpr auto operator == (rgb const& lhs, rgb const& rhs) -> bool
+        {
+            return lhs.hex() == rhs.hex();
+        }
+
+        [[nodiscard]]
+        friend constexpr auto operator != (rgb const& lhs, rgb const& rhs) -> bool
+        {
+            return !(lhs == rhs);
+        }
+    };
+
+    /**
+     * \struct hsl
+     *
+     * \brief Color in the HSL space: hue in degrees `[0, 360)`, saturation and lightness in `[0, 1]`
+    */
+    struct hsl
+    {
+        double h = 0, s = 0, l = 0;
+    };
+
+    /**
+     * \struct oklab
+     *
+     * \brief Color in the perceptually uniform OKLab space (lightness `L` in `[0, 1]`)
+    */
+    struct oklab
+    {
+        double L = 0, a = 0, b = 0;
+    };
+
+    // SECTION Math helpers
+    /// \internal Functions of `<cmath>` aren't `constexpr`, so the needed ones are defined here
+    namespace _math
+    {
+        constexpr auto clamp (double x, double lo, double hi) -> double
+        {
+            return x < lo ? lo : x > hi ? hi : x;
+        }
+
+        constexpr auto round_byte (double x) -> uint8_t
+        {
+            return (uint8_t)(clamp(x, 0, 1) * 255 + 0.5);
+        }
+
+        /// Natural logarithm; NaN for negative numbers and NaN
+        constexpr auto log (double x) -> double
+        {
+            constexpr double ln2 = 0.693147180559945309417;
+
+            // The reduction below never ends for these
+            if (!(x >= 0)) return std::numeric_limits<double>::quiet_NaN();
+            if (x == 0) return -std::numeric_limits<double>::infinity();
+            if (x > std::numeric_limits<double>::max()) return x;
+
+            // x = m * 2^e, m in [1, 2)
+            auto e = 0;
+            while (x >= 2) x /= 2, ++e;
+            while (x < 1) x *= 2, --e;
+
+            // ln(m) = 2 atanh((m - 1) / (m + 1))
+            auto z = (x - 1) / (x + 1), z2 = z * z, term = z, sum = 0.0;
+            for (auto k = 1; k < 40; k += 2, term *= z2) sum += term / k;
+
+            return 2 * sum + e * ln2;
+        }
+
+        constexpr auto exp (double x) -> double
+        {
+            constexpr double ln2 = 0.693147180559945309417;
+
+            // Beyond the range of the result (and of `k` below)
+            if (x != x) return x;
+            if (x > 710) return std::numeric_limits<double>::infinity();
+            if (x < -746) return 0;
+
+            // x = k ln2 + r, |r| <= ln2 / 2
+            auto k = (int)(x / ln2 + (x < 0 ? -0.5 : 0.5));
+            auto r = x - k * ln2;
+
+            auto term = 1.0, sum = 1.0;
+            for (auto n = 1; n < 24; ++n) sum += term *= r / n;
+
+            for (; k > 0; --k) sum *= 2;
+            for (; k < 0; ++k) sum /= 2;
+
+            return sum;
+        }
+
+        constexpr auto pow (double x, double y) -> double
+        {
+            return x <= 0 ? 0 : exp(y * log(x));
+        }
+
+        constexpr auto cbrt (double x) -> double
+        {
+            return x < 0 ? -pow(-x, 1.0 / 3) : pow(x, 1.0 / 3);
+        }
+    }
+    // !SECTION
+
+    // SECTION Conversions
+    /**
+     * \brief Converts an sRGB component into the linear light
+     *
+     * \param c Gamma-encoded component in `[0, 1]`
+    */
+    [[nodiscard]]
+    constexpr auto to_linear (double c) -> double
+    {
+        return c <= 0.04045 ? c / 12.92 : _math::pow((c + 0.055) / 1.055, 2.4);
+    }
+
+    /**
+     * \brief Converts a linear light component into the sRGB one
+     *
+     * \param c Linear component in `[0, 1]`
+    */
+    [[nodiscard]]
+    constexpr auto from_linear (double c) -> double
+    {
+        return c <= 0.0031308 ? c * 12.92 : 1.055 * _math::pow(c, 1 / 2.4) - 0.055;
+    }
+
+    /**
+     * \brief Converts an sRGB color into HSL
+    */
+    [[nodiscard]]
+    constexpr auto to_hsl (rgb c) -> hsl
+    {
+        double r = c.r / 255.0, g = c.g / 255.0, b = c.b / 255.0;
+
+        auto max = r > g ? (r > b ? r : b) : (g > b ? g : b);
+        auto min = r < g ? (r < b ? r : b) : (g < b ? g : b);
+        auto l = (max + min) / 2;
+
+        if (max == min) return { 0, 0, l };
+
+        auto d = max - min;
+        auto s = l > 0.5 ? d / (2 - max - min) : d / (max + min);
+
+        auto h = max == r ? (g - b) / d + (g < b ? 6 : 0)
+               : max == g ? (b - r) / d + 2
+               : (r - g) / d + 4;
+
+        return { h * 60, s, l };
+    }
+
+    /**
+     * \brief Converts an HSL color into sRGB
+    */
+    [[nodiscard]]
+    constexpr auto to_rgb (hsl c) -> rgb
+    {
+        auto h = c.h - 360 * (double)(long long)(c.h / 360);
+        if (h < 0) h += 360;
+
+        auto s = _math::clamp(c.s, 0, 1), l = _math::clamp(c.l, 0, 1);
+
+        if (s == 0) return { _math::round_byte(l), _math::round_byte(l), _math::round_byte(l) };
+
+        auto q = l < 0.5 ? l * (1 + s) : l + s - l * s;
+        auto p = 2 * l - q;
+
+        auto channel = [p, q] (double t)
+        {
+            if (t < 0) t += 1;
+            if (t > 1) t -= 1;
+
+            if (t < 1.0 / 6) return p + (q - p) * 6 * t;
+            if (t < 1.0 / 2) return q;
+            if (t < 2.0 / 3) return p + (q - p) * (2.0 / 3 - t) * 6;
+            return p;
+        };
+        h /= 360;
+
+        return { _math::round_byte(channel(h + 1.0 / 3)), _math::round_byte(channel(h)), _math::round_byte(channel(h - 1.0 / 3)) };
+    }
+
+    /**
+     * \brief Converts an sRGB color into OKLab
+    */
+    [[nodiscard]]
+    constexpr auto to_oklab (rgb c) -> oklab
+    {
+        auto r = to_linear(c.r / 255.0), g = to_linear(c.g / 255.0), b = to_linear(c.b / 255.0);
+
+        auto l = _math::cbrt(0.4122214708 * r + 0.5363325363 * g + 0.0514459929 * b);
+        auto m = _math::cbrt(0.2119034982 * r + 0.6806995451 * g + 0.1073969566 * b);
+        auto s = _math::cbrt(0.0883024619 * r + 0.2817188376 * g + 0.6299787005 * b);
+
+        return {
+            0.2104542553 * l + 0.7936177850 * m - 0.0040720468 * s,
+            1.9779984951 * l - 2.4285922050 * m + 0.4505937099 * s,
+            0.0259040371 * l + 0.7827717662 * m - 0.8086757660 * s,
+        };
+    }
+
+    /**
+     * \brief Converts an OKLab color into sRGB (out-of-gamut colors are clipped)
+    */
+    [[nodiscard]]
+    constexpr auto to_rgb (oklab c) -> rgb
+    {
+        auto l = c.L + 0.3963377774 * c.a + 0.2158037573 * c.b;
+        auto m = c.L - 0.1055613458 * c.a - 0.0638541728 * c.b;
+        auto s = c.L - 0.0894841775 * c.a - 1.2914855480 * c.b;
+
+        l = l * l * l, m = m * m * m, s = s * s * s;
+
+        auto r = +4.0767416621 * l - 3.3077115913 * m + 0.2309699292 * s;
+        auto g = -1.2684380046 * l + 2.6097574011 * m - 0.3413193965 * s;
+        auto b = -0.0041960863 * l - 0.7034186147 * m + 1.7076147010 * s;
+
+        return {
+            _math::round_byte(from_linear(_math::clamp(r, 0, 1))),
+            _math::round_byte(from_linear(_math::clamp(g, 0, 1))),
+            _math::round_byte(from_linear(_math::clamp(b, 0, 1))),
+        };
+    }
+    // !SECTION
+
+    // SECTION Interpolation and metrics
+    /**
+     * \brief Interpolates between the colors component-wise in sRGB
+     *
+     * \param from, to Colors
+     * \param t Position between them in `[0, 1]`
+    */
+    [[nodiscard]]
+    constexpr auto lerp (rgb from, rgb to, double t) -> rgb
+    {
+        t = _math::clamp(t, 0, 1);
+
+        auto mix = [t] (uint8_t a, uint8_t b) { return (uint8_t)(a + (b - a) * t + 0.5); };
+        return { mix(from.r, to.r), mix(from.g, to.g), mix(from.b, to.b) };
+    }
+
+    /**
+     * \brief Interpolates between the colors in OKLab, i.e. with perceptually even steps
+     *
+     * \param from, to Colors
+     * \param t Position between them in `[0, 1]`
+    */
+    [[nodiscard]]
+    constexpr auto lerp_oklab (rgb from, rgb to, double t) -> rgb
+    {
+        t = _math::clamp(t, 0, 1);
+
+        auto a = to_oklab(from), b = to_oklab(to);
+        return to_rgb(oklab{ a.L + (b.L - a.L) * t, a.a + (b.a - a.a) * t, a.b + (b.b - a.b) * t });
+    }
+
+    /**
+     * \brief Puts a translucent color over another one (mixing in the linear light)
+     *
+     * \param top Color on top
+     * \param bottom Color below
+     * \param alpha Opacity of the top color in `[0, 1]`
+    */
+    [[nodiscard]]
+    constexpr auto blend (rgb top, rgb bottom, double alpha) -> rgb
+    {
+        alpha = _math::clamp(alpha, 0, 1);
+
+        auto mix = [alpha] (uint8_t a, uint8_t b)
+        {
+            auto la = to_linear(a / 255.0), lb = to_linear(b / 255.0);
+            return _math::round_byte(from_linear(la * alpha + lb * (1 - alpha)));
+        };
+        return { mix(top.r, bottom.r), mix(top.g, bottom.g), mix(top.b, bottom.b) };
+    }
+
+    /**
+     * \brief Returns the relative luminance of the color (WCAG 2), from 0 for black to 1 for white
+    */
+    [[nodiscard]]
+    constexpr auto luminance (rgb c) -> double
+    {
+        return 0.2126 * to_linear(c.r / 255.0) + 0.7152 * to_linear(c.g / 255.0) + 0.0722 * to_linear(c.b / 255.0);
+    }
+
+    /**
+     * \brief Returns the contrast ratio of the colors (WCAG 2), from 1 to 21
+    */
+    [[nodiscard]]
+    constexpr auto contrast_ratio (rgb c1, rgb c2) -> double
+    {
+        auto l1 = luminance(c1), l2 = luminance(c2);
+        if (l1 < l2) { auto t = l1; l1 = l2; l2 = t; }
+
+        return (l1 + 0.05) / (l2 + 0.05);
+    }
+
+    /**
+     * \brief Builds evenly spaced stops of a gradient, interpolated in OKLab
+     *
+     * \tparam N Number of stops (at least 2)
+     *
+     * \param from, to First and last colors
+    */
+    template <std::size_t N>
+    [[nodiscard]]
+    constexpr auto make_gradient (rgb from, rgb to) -> std::array<rgb, N>
+    {
+        static_assert(N >= 2, "a gradient has at least two stops");
+
+        std::array<rgb, N> stops = {};
+        for (std::size_t i = 0; i < N; ++i) stops[i] = lerp_oklab(from, to, (double)i / (N - 1));
+
+        return stops;
+    }
+    // !SECTION
+
+    // SECTION Terminal colors
+    /// Colors of the 16 basic codes (xterm palette): 30...37 (40...47), then the bright ones
+    inline constexpr rgb xterm_palette[16] = {
+        { 0, 0, 0 }, { 205, 0, 0 }, { 0, 205, 0 }, { 205, 205, 0 },
+        { 0, 0, 238 }, { 205, 0, 205 }, { 0, 205, 205 }, { 229, 229, 229 },
+        { 127, 127, 127 }, { 255, 0, 0 }, { 0, 255, 0 }, { 255, 255, 0 },
+        { 92, 92, 255 }, { 255, 0, 255 }, { 0, 255, 255 }, { 255, 255, 255 },
+    };
+
+    /**
+     * \brief Returns the index of the nearest color of `xterm_palette` (by the distance in sRGB)
+    */
+    [[nodiscard]]
+    constexpr auto nearest_basic (rgb c) -> unsigned
+    {
+        unsigned best = 0;
+        long best_distance = -1;
+
+        for (unsigned i = 0; i < 16; ++i)
+        {
+            long dr = c.r - xterm_palette[i].r, dg = c.g - xterm_palette[i].g, db = c.b - xterm_palette[i].b;
+            auto distance = dr * dr + dg * dg + db * db;
+
+            if (best_distance < 0 || distance < best_distance) best = i, best_distance = distance;
+        }
+        return best;
+    }
+
+    /**
+     * \brief Returns the color of an entry of the 256-color palette
+    */
+    [[nodiscard]]
+    constexpr auto indexed_color (uint8_t index) -> rgb
+    {
+        if (index < 16) return xterm_palette[index];
+        if (index >= 232)
+        {
+            auto level = (uint8_t)(8 + 10 * (index - 232));
+            return { level, level, level };
+        }
+        index -= 16;
+
+        auto level = [] (int v) { return (uint8_t)(v ? 55 + 40 * v : 0); };
+        return { level(index / 36), level(index / 6 % 6), level(index % 6) };
+    }
+
+    /**
+     * \brief Returns the nearest basic foreground color
+    */
+    [[nodiscard]]
+    constexpr auto nearest_face (rgb c) -> face
+    {
+        auto i = nearest_basic(c);
+        return face{ (uint8_t)(i < 8 ? 30 + i : 82 + i) };
+    }
+
+    /**
+     * \brief Returns the nearest basic background color
+    */
+    [[nodiscard]]
+    constexpr auto nearest_back (rgb c) -> back
+    {
+        auto i = nearest_basic(c);
+        return back{ (uint8_t)(i < 8 ? 40 + i : 92 + i) };
+    }
+
+    /**
+     * \brief Builds the true-color sequence which sets the foreground color
+    */
+    [[nodiscard]]
+    constexpr auto foreground_escape (rgb c) -> escape
+    {
+        escape seq;
+        seq.push('\033').push('[').push(38u).push(';').push(2u).push(';');
+        seq.push((unsigned)c.r).push(';').push((unsigned)c.g).push(';').push((unsigned)c.b);
+
+        return seq.push('m'), seq;
+    }
+
+    /**
+     * \brief Builds the true-color sequence which sets the background color
+    */
+    [[nodiscard]]
+    constexpr auto background_escape (rgb c) -> escape
+    {
+        escape seq;
+        seq.push('\033').push('[').push(48u).push(';').push(2u).push(';');
+        seq.push((unsigned)c.r).push(';').push((unsigned)c.g).push(';').push((unsigned)c.b);
+
+        return seq.push('m'), seq;
+    }
+    // !SECTION
+
+}   // end namespace tesc
+
+#endif  // TESC_COLORMATH_H
+
+// MIT License
+//
+// Copyright (c) 2020-2021 Alex Qzminsky
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
@@ -0,0 +1,512 @@
+#pragma once
+
+// Copyright © 2020-2021 Alex Qzminsky.
+// License: MIT. All rights reserved.
+
+/// \brief `LS_COLORS` parser with constant-time lookup of file styles
+///
+/// \author https://github.com/qzminsky
+
+#ifndef TESC_DIRCOLORS_H
+#define TESC_DIRCOLORS_H
+
+#include "colormath.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tesc
+{
+    /**
+     * \enum file_kind
+     *
+     * \brief Type of a file as `LS_COLORS` distinguishes them
+    */
+    enum class file_kind : uint8_t
+    {
+        normal,                 ///< `no`: any file without a more specific entry
+        file,                   ///< `fi`: regular file
+        directory,              ///< `di`
+        symlink,                ///< `ln`
+        fifo,                   ///< `pi`
+        socket,                 ///< `so`
+        block_device,           ///< `bd`
+        char_device,            ///< `cd`
+        orphan,                 ///< `or`: symbolic link to a missing file
+        missing,                ///< `mi`: missing target of an orphan link
+        setuid,                 ///< `su`
+        setgid,                 ///< `sg`
+        capability,             ///< `ca`
+        executable,             ///< `ex`
+        multi_hardlink,         ///< `mh`: regular file with more than one link
+        sticky,                 ///< `st`: sticky directory
+        other_writable,         ///< `ow`: other-writable directory
+        sticky_other_writable,  ///< `tw`
+        door,                   ///< `do`
+    };
+
+    /**
+     * \class dircolors
+     *
+     * \brief Styles of files by their types and extensions, parsed from `LS_COLORS`
+     *
+     * \details SGR strings of the entries are mapped onto `state` (256 and true colors are
+     * replaced by the nearest of the 16 ones, other attributes are dropped) and pre-rendered into
+     * escape sequences. Extensions are put into a perfect hash table built at construction, so a
+     * lookup takes a bounded number of hashings and a single comparison, and never allocates
+     *
+     * \note Extensions are matched case-insensitively. Suffixes without a dot (e.g. `*~`) are
+     * checked one by one, as there are usually only a few of them. Entries which can't be parsed
+     * are skipped, as `ls` would not apply them either
+    */
+    class dircolors
+    {
+    public:
+
+        /**
+         * \struct entry
+         *
+         * \brief Style of a file and its pre-rendered escape sequence
+        */
+        struct entry
+        {
+            state style;
+            escape seq;                         ///< Empty for the default style
+            bool defined = false;               ///< Whether the entry came from `LS_COLORS`
+        };
+
+    private:
+
+        static constexpr std::size_t _kinds = (std::size_t)file_kind::door + 1;
+        static constexpr std::size_t _max_extension = 64;
+
+        /// Extension of the hash table: `[offset, offset + length)` of the arena
+        struct _slot
+        {
+            uint32_t offset = 0;
+            uint32_t length = 0;                ///< Zero for the empty slot
+            entry value;
+        };
+
+        entry _by_kind[_kinds];
+        std::string _arena;                     ///< Lower-case extensions, including the dots
+        std::vector<uint32_t> _seeds;           ///< Displacement seed of each bucket
+        std::vector<_slot> _slots;
+        std::vector<std::pair<std::string, entry>> _suffixes;
+        std::size_t _longest = 0;               ///< Length of the longest extension
+        bool _link_as_target = false;           ///< `ln=target`: links are styled as their targets
+
+    public:
+
+        /**
+         * \brief Default constructor. No file is styled
+        */
+        dircolors () = default;
+
+        /**
+         * \brief Parses the `LS_COLORS` value
+         *
+         * \param spec List of `key=SGR` entries separated by colons, e.g. `"di=01;34:*.tar=01;31"`;
+         * the `ln` entry may also be `target`
+        */
+        explicit dircolors (std::string_view spec)
+        {
+            std::vector<std::pair<std::string, entry>> extensions;
+
+            for (std::size_t pos = 0; pos < spec.size();)
+            {
+                auto end = std::min(spec.find(':', pos), spec.size());
+                auto item = spec.substr(pos, end - pos);
+                pos = end + 1;
+
+                if (item.empty()) continue;
+
+                auto eq = item.find('=');
+                if (eq == item.npos || !eq) continue;
+
+                auto key = item.substr(0, eq);
+
+                if (key == "ln" && item.substr(eq + 1) == "target")
+                {
+                    _link_as_target = true;
+                    continue;
+                }
+
+                auto parsed = _parse_sgr(item.substr(eq + 1));
+                if (!parsed) continue;
+
+                auto& value = *parsed;
+
+                if (key[0] == '*')
+                {
+                    auto suffix = _lower(key.substr(1));
+
+                    if (suffix.size() > 1 && suffix[0] == '.' && suffix.size() <= _max_extension)
+                    {
+                        extensions.emplace_back(std::move(suffix), value);
+                    }
+                    else if (!suffix.empty()) _suffixes.emplace_back(std::move(suffix), value);
+
+                    continue;
+                }
+                if (auto kind = _parse_kind(key); kind < _kinds) _by_kind[kind] = value;
+            }
+            _build(extensions);
+        }
+
+        /**
+         * \brief Parses the `LS_COLORS` environment variable
+        */
+        [[nodiscard]]
+        static auto from_env () -> dircolors
+        {
+            auto const* value = std::getenv("LS_COLORS");
+            return value ? dircolors{ value } : dircolors{};
+        }
+
+        /**
+         * \brief Returns the style of a file
+         *
+         * \details Like `ls` does, extensions are taken into account for regular files only,
+         * and only if there is no entry of a more specific type (e.g. `ex` for executables).
+         * With `ln=target` a link gets the style of a regular file of its name; the callers
+         * which know the type of the target may look it up instead (see `links_as_targets()`)
+         *
+         * \param name File name (or path)
+         * \param kind Type of the file
+         *
+         * \return Entry of the file; the default one if nothing matches
+        */
+        [[nodiscard]]
+        auto lookup (std::string_view name, file_kind kind = file_kind::file) const -> entry const&
+        {
+            static constexpr entry none = {};
+
+            auto& own = _by_kind[(std::size_t)kind];
+
+            switch (kind)
+            {
+            case file_kind::file:
+            case file_kind::setuid:
+            case file_kind::setgid:
+            case file_kind::capability:
+            case file_kind::executable:
+            case file_kind::multi_hardlink:
+                if (kind != file_kind::file && own.defined) return own;
+                if (auto* found = _by_extension(name)) return *found;
+                if (auto& fi = _by_kind[(std::size_t)file_kind::file]; fi.defined) return fi;
+                break;
+
+            case file_kind::sticky:
+            case file_kind::other_writable:
+            case file_kind::sticky_other_writable:
+                if (own.defined) return own;
+                if (auto& di = _by_kind[(std::size_t)file_kind::directory]; di.defined) return di;
+                break;
+
+            case file_kind::symlink:
+                if (_link_as_target) return lookup(name, file_kind::file);
+                if (own.defined) return own;
+                break;
+
+            case file_kind::orphan:
+                if (own.defined) return own;
+                if (auto& ln = _by_kind[(std::size_t)file_kind::symlink]; ln.defined) return ln;
+                break;
+
+            default:
+                if (own.defined) return own;
+            }
+
+            auto& no = _by_kind[(std::size_t)file_kind::normal];
+            return no.defined ? no : none;
+        }
+
+        /**
+         * \brief Returns the number of the extensions and suffixes
+        */
+        [[nodiscard]]
+        auto extensions () const -> std::size_t
+        {
+            std::size_t count = _suffixes.size();
+            for (auto& slot : _slots) count += slot.length != 0;
+
+            return count;
+        }
+
+        /**
+         * \brief Predicate. Checks if links are styled as their targets (`ln=target`)
+        */
+        [[nodiscard]]
+        auto links_as_targets () const -> bool
+        {
+            return _link_as_target;
+        }
+
+    private:
+
+        static auto _lower (std::string_view text) -> std::string
+        {
+            std::string out{ text };
+            for (auto& ch : out) if (ch >= 'A' && ch <= 'Z') ch = char(ch - 'A' + 'a');
+
+            return out;
+        }
+
+        static auto _parse_kind (std::string_view key) -> std::size_t
+        {
+            constexpr std::string_view keys[_kinds] = {
+                "no", "fi", "di", "ln", "pi", "so", "bd", "cd", "or", "mi",
+                "su", "sg", "ca", "ex", "mh", "st", "ow", "tw", "do",
+            };
+            return (std::size_t)(std::find(std::begin(keys), std::end(keys), key) - std::begin(keys));
+        }
+
+        /// \return The entry, or nothing if the string isn't a list of numeric parameters
+        static auto _parse_sgr (std::string_view sgr) -> std::optional<entry>
+        {
+            unsigned params[16];
+            std::size_t count = 0;
+
+            for (std::size_t pos = 0; pos <= sgr.size();)
+            {
+                auto end = std::min(sgr.find(';', pos), sgr.size());
+                unsigned value = 0;
+
+                for (auto i = pos; i < end; ++i)
+                {
+                    if (sgr[i] < '0' || sgr[i] > '9' || value > 1000) return std::nullopt;
+                    value = value * 10 + (unsigned)(sgr[i] - '0');
+                }
+                if (count == std::size(params)) return std::nullopt;
+
+                params[count++] = value;
+                pos = end + 1;
+            }
+
+            auto fg = face::none;
+            auto bg = back::none;
+            auto st = (uint8_t)style::normal;
+
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                auto p = params[i];
+
+                switch (p)
+                {
+                case 0: fg = face::none; bg = back::none; st = 0; break;
+                case 1: st |= (uint8_t)style::bold; break;
+                case 3: st |= (uint8_t)style::italic; break;
+                case 4: st |= (uint8_t)style::underline; break;
+
+                case 38: case 48: {
+                    // Extended colors are replaced by the nearest basic ones
+                    auto basic = 16u;
+
+                    if (i + 2 < count && params[i + 1] == 5)
+                    {
+                        basic = nearest_basic(indexed_color((uint8_t)std::min(params[i + 2], 255u)));
+                        i += 2;
+                    }
+                    else if (i + 4 < count && params[i + 1] == 2)
+                    {
+                        auto channel = [] (unsigned v) { return (uint8_t)std::min(v, 255u); };
+                        basic = nearest_basic({ channel(params[i + 2]), channel(params[i + 3]), channel(params[i + 4]) });
+                        i += 4;
+                    }
+                    if (basic == 16) break;
+
+                    auto code = (uint8_t)(basic < 8 ? basic : basic + 52);
+
+                    if (p == 38) fg = face{ (uint8_t)(30 + code) };
+                    else bg = back{ (uint8_t)(40 + code) };
+                    break;
+                }
+                default:
+                    if ((p >= 30 && p <= 37) || (p >= 90 && p <= 97)) fg = face{ (uint8_t)p };
+                    else if ((p >= 40 && p <= 47) || (p >= 100 && p <= 107)) bg = back{ (uint8_t)p };
+                }
+            }
+
+            entry result;
+            result.style = state{ fg, bg, style{ st } };
+            result.seq = transition({}, result.style);
+
+            // Like `ls`, taking `00` as "not colored", so a more generic entry applies
+            result.defined = std::any_of(params, params + count, [] (unsigned p) { return p != 0; });
+
+            return result;
+        }
+
+        static auto _hash (char const* data, std::size_t length, uint32_t seed) -> uint32_t
+        {
+            uint64_t h = 0x9E3779B97F4A7C15ull * (seed + 1) ^ length;
+
+            for (std::size_t i = 0; i < length; ++i) h = (h ^ (uint8_t)data[i]) * 0x100000001B3ull;
+
+            h ^= h >> 29;
+            h *= 0xBF58476D1CE4E5B9ull;
+            return (uint32_t)(h ^ h >> 32);
+        }
+
+        /**
+         * \brief Builds the perfect hash table by the hash-and-displace method
+         *
+         * \details Keys are distributed into buckets by the seed 0; then, from the largest bucket,
+         * each one gets the first seed which puts all its keys into free slots
+        */
+        void _build (std::vector<std::pair<std::string, entry>>& extensions)
+        {
+            // The later entry wins, as `ls` does
+            std::reverse(extensions.begin(), extensions.end());
+            std::stable_sort(extensions.begin(), extensions.end(), [] (auto& a, auto& b) { return a.first < b.first; });
+            extensions.erase(
+                std::unique(extensions.begin(), extensions.end(), [] (auto& a, auto& b) { return a.first == b.first; }),
+                extensions.end()
+            );
+            std::reverse(_suffixes.begin(), _suffixes.end());
+
+            if (extensions.empty()) return;
+
+            for (auto& [ext, value] : extensions) _longest = std::max(_longest, ext.size());
+
+            auto const n = extensions.size();
+
+            for (std::size_t size = 1; ; size *= 2)
+            {
+                if (size < n + n / 4) continue;
+
+                std::vector<std::vector<uint32_t>> buckets((n + 3) / 4);
+                for (uint32_t k = 0; k < n; ++k)
+                {
+                    auto& ext = extensions[k].first;
+                    buckets[_hash(ext.data(), ext.size(), 0) % buckets.size()].push_back(k);
+                }
+
+                std::vector<uint32_t> order(buckets.size());
+                for (uint32_t b = 0; b < order.size(); ++b) order[b] = b;
+                std::stable_sort(order.begin(), order.end(), [&] (auto a, auto b) { return buckets[a].size() > buckets[b].size(); });
+
+                _seeds.assign(buckets.size(), 0);
+                std::vector<int64_t> taken(size, -1);
+                auto placed = true;
+
+                for (auto b : order)
+                {
+                    if (buckets[b].empty()) break;
+
+                    uint32_t seed = 1;
+                    for (; seed < (1u << 16); ++seed)
+                    {
+                        std::size_t k = 0;
+                        for (; k < buckets[b].size(); ++k)
+                        {
+                            auto& ext = extensions[buckets[b][k]].first;
+                            auto slot = _hash(ext.data(), ext.size(), seed) & (size - 1);
+
+                            if (taken[slot] >= 0) break;
+                            taken[slot] = buckets[b][k];
+                        }
+                        if (k == buckets[b].size()) break;
+
+                        // Releasing the slots of this attempt
+                        while (k--)
+                        {
+                            auto& ext = extensions[buckets[b][k]].first;
+                            taken[_hash(ext.data(), ext.size(), seed) & (size - 1)] = -1;
+                        }
+                    }
+                    if (seed == (1u << 16)) { placed = false; break; }
+
+                    _seeds[b] = seed;
+                }
+                if (!placed) continue;
+
+                _slots.assign(size, {});
+                for (std::size_t s = 0; s < size; ++s)
+                {
+                    if (taken[s] < 0) continue;
+
+                    auto& [ext, value] = extensions[(std::size_t)taken[s]];
+                    _slots[s] = { (uint32_t)_arena.size(), (uint32_t)ext.size(), value };
+                    _arena += ext;
+                }
+                return;
+            }
+        }
+
+        /**
+         * \brief Finds the entry of the longest known extension of the name
+        */
+        auto _by_extension (std::string_view name) const -> entry const*
+        {
+            if (!_slots.empty())
+            {
+                char lower[_max_extension];
+
+                // Trying the extensions from the longest one, i.e. from the leftmost dot
+                auto tail = name.substr(name.size() - std::min(name.size(), _longest));
+
+                for (auto dot = tail.find('.'); dot != tail.npos; dot = tail.find('.', dot + 1))
+                {
+                    auto ext = tail.substr(dot);
+                    for (std::size_t i = 0; i < ext.size(); ++i)
+                    {
+                        auto ch = ext[i];
+                        lower[i] = ch >= 'A' && ch <= 'Z' ? char(ch - 'A' + 'a') : ch;
+                    }
+
+                    auto bucket = _hash(lower, ext.size(), 0) % _seeds.size();
+                    auto& slot = _slots[_hash(lower, ext.size(), _seeds[bucket]) & (_slots.size() - 1)];
+
+                    if (slot.length == ext.size() && !std::memcmp(_arena.data() + slot.offset, lower, ext.size()))
+                    {
+                        return &slot.value;
+                    }
+                }
+            }
+
+            for (auto& [suffix, value] : _suffixes)
+            {
+                if (name.size() < suffix.size()) continue;
+
+                auto tail = name.substr(name.size() - suffix.size());
+                auto equal = std::equal(tail.begin(), tail.end(), suffix.begin(), [] (char a, char b) {
+                    return (a >= 'A' && a <= 'Z' ? char(a - 'A' + 'a') : a) == b;
+                });
+                if (equal) return &value;
+            }
+            return nullptr;
+        }
+    };
+
+}   // end namespace tesc
+
+#endif  // TESC_DIRCOLORS_H
+
+// MIT License
+//
+// Copyright (c) 2020-2021 Alex Qzminsky
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
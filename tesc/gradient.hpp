@@ -0,0 +1,463 @@
+#pragma once
+
+// Copyright © 2020-2021 Alex Qzminsky.
+// License: MIT. All rights reserved.
+
+/// \brief True-color gradients and heatmaps
+///
+/// \author https://github.com/qzminsky
+
+#ifndef TESC_GRADIENT_H
+#define TESC_GRADIENT_H
+
+#include "colormath.hpp"
+
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+namespace tesc
+{
+    /**
+     * \internal
+     * \brief Decimal texts of the byte values, for writing the color parameters without division
+    */
+    struct _byte_text
+    {
+        char text[3];
+        uint8_t size;
+    };
+
+    /// \internal Builds the table of `_byte_text`
+    constexpr auto _make_byte_texts () -> std::array<_byte_text, 256>
+    {
+        std::array<_byte_text, 256> table = {};
+
+        for (unsigned v = 0; v < 256; ++v)
+        {
+            auto& t = table[v];
+
+            if (v >= 100) t.text[t.size++] = char('0' + v / 100);
+            if (v >= 10) t.text[t.size++] = char('0' + v / 10 % 10);
+            t.text[t.size++] = char('0' + v % 10);
+        }
+        return table;
+    }
+
+    /// \internal Decimal texts of the byte values
+    inline constexpr auto _byte_texts = _make_byte_texts();
+
+    /// \internal Length of `ESC [38;2;255;255;255m`
+    inline constexpr std::size_t _max_rgb_escape = 19;
+
+    /**
+     * \internal
+     * \brief Enlarges the buffer for the worst case and returns the end of the old contents
+    */
+    inline auto _grow_buffer (std::string& out, std::size_t extra) -> char*
+    {
+        auto size = out.size();
+        out.resize(size + extra);
+
+        return out.data() + size;
+    }
+
+    /// \internal Writes the true-color sequence of the packed color
+    inline auto _write_rgb (char* p, uint32_t color, bool background) -> char*
+    {
+        *p++ = '\033'; *p++ = '[';
+        *p++ = background ? '4' : '3'; *p++ = '8'; *p++ = ';'; *p++ = '2';
+
+        for (auto shift : { 16, 8, 0 })
+        {
+            auto& t = _byte_texts[(color >> shift) & 0xFF];
+
+            *p++ = ';';
+            for (std::size_t i = 0; i < t.size; ++i) *p++ = t.text[i];
+        }
+        *p++ = 'm';
+
+        return p;
+    }
+
+    /// \internal Writes the sequence which resets the foreground or the background color
+    inline auto _write_default_color (char* p, bool background) -> char*
+    {
+        *p++ = '\033'; *p++ = '[';
+        *p++ = background ? '4' : '3'; *p++ = '9'; *p++ = 'm';
+
+        return p;
+    }
+
+    /**
+     * \class gradient
+     *
+     * \brief Evenly spaced color stops, rendered as per-cell true colors
+     *
+     * \details Within each pair of stops the color channels are affine in the cell index, so
+     * the colors of the cells are computed four at once (SSE2, if enabled at compile time).
+     * Rendering writes the `38;2;r;g;b` parameters from a table of digit texts into a single
+     * buffer, and the sequence is skipped where the color of a cell, quantized to the given
+     * precision, is the same as the previous one
+     *
+     * \note Stops are interpolated in sRGB; use `make_gradient()` to get perceptually even
+     * intermediate stops (OKLab)
+    */
+    class gradient
+    {
+        std::vector<rgb> _stops;
+        uint32_t _mask = 0xFFFFFF;              ///< Bits of the packed color which are compared
+        uint32_t _lut[257];                     ///< Colors of 257 evenly spaced positions, for heatmaps
+
+    public:
+
+        /**
+         * \brief Constructs the gradient by its stops
+         *
+         * \param stops Colors; the first and the last ones are at the ends
+         *
+         * \throw std::invalid_argument if there are less than two stops
+        */
+        gradient (std::initializer_list<rgb> stops) : gradient{ std::vector<rgb>{ stops } } {}
+
+        /**
+         * \brief Constructs the gradient by its stops
+         *
+         * \param stops Colors; the first and the last ones are at the ends
+         *
+         * \throw std::invalid_argument if there are less than two stops
+        */
+        explicit gradient (std::vector<rgb> stops) : _stops{ std::move(stops) }
+        {
+            if (_stops.size() < 2) throw std::invalid_argument{ "tesc::gradient: at least two stops are required" };
+
+            sample(257, _lut);
+        }
+
+        /**
+         * \brief Sets the number of bits per channel which tell the neighbor colors apart
+         *
+         * \details Lower precision makes less escape sequences: neighbor cells with close
+         * colors get the color of the first of them
+         *
+         * \param bits From 1 to 8 (default)
+         *
+         * \return Reference to the gradient itself
+        */
+        auto set_precision (unsigned bits) -> gradient&
+        {
+            bits = bits < 1 ? 1 : bits > 8 ? 8 : bits;
+
+            auto channel = (0xFFu << (8 - bits)) & 0xFF;
+            _mask = channel << 16 | channel << 8 | channel;
+
+            return *this;
+        }
+
+        /**
+         * \brief Computes the colors of evenly spaced cells
+         *
+         * \param n Number of cells; the first and the last ones get the first and the last stops
+         * \param out Packed colors (`0xRRGGBB`), `n` of them
+        */
+        void sample (std::size_t n, uint32_t* out) const
+        {
+            if (!n) return;
+            if (n == 1) { out[0] = _stops.front().hex(); return; }
+
+            auto const segments = _stops.size() - 1;
+            auto const scale = (float)segments / (float)(n - 1);
+
+            for (std::size_t k = 0, begin = 0; k < segments; ++k)
+            {
+                // Cells with `i * segments < (k + 1) * (n - 1)` belong to the segment `k`
+                auto end = k + 1 == segments ? n : ((k + 1) * (n - 1) + segments - 1) / segments;
+
+                auto from = _stops[k], to = _stops[k + 1];
+
+                // c(i) = base + slope * i
+                float slope[3], base[3];
+                uint8_t const a[3] = { from.r, from.g, from.b }, b[3] = { to.r, to.g, to.b };
+
+                for (auto c = 0; c < 3; ++c)
+                {
+                    auto d = (float)b[c] - (float)a[c];
+
+                    slope[c] = d * scale;
+                    base[c] = (float)a[c] - d * (float)k + 0.5f;   // Rounding by truncation
+                }
+
+                auto i = begin;
+
+            #if defined(__SSE2__)
+                auto const step = _mm_set_ps(3, 2, 1, 0);
+                auto const zero = _mm_setzero_ps();
+                auto const top = _mm_set1_ps(255.5f);
+
+                __m128 const slopes[3] = { _mm_set1_ps(slope[0]), _mm_set1_ps(slope[1]), _mm_set1_ps(slope[2]) };
+                __m128 const bases[3] = { _mm_set1_ps(base[0]), _mm_set1_ps(base[1]), _mm_set1_ps(base[2]) };
+
+                for (; i + 4 <= end; i += 4)
+                {
+                    auto index = _mm_add_ps(_mm_set1_ps((float)i), step);
+                    __m128i channel[3];
+
+                    for (auto c = 0; c < 3; ++c)
+                    {
+                        auto value = _mm_add_ps(bases[c], _mm_mul_ps(slopes[c], index));
+                        channel[c] = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(value, zero), top));
+                    }
+                    auto packed = _mm_or_si128(
+                        _mm_or_si128(_mm_slli_epi32(channel[0], 16), _mm_slli_epi32(channel[1], 8)),
+                        channel[2]
+                    );
+                    _mm_storeu_si128((__m128i*)(out + i), packed);
+                }
+            #endif
+
+                for (; i < end; ++i)
+                {
+                    uint32_t packed = 0;
+                    for (auto c = 0; c < 3; ++c)
+                    {
+                        auto value = base[c] + slope[c] * (float)i;
+                        packed = packed << 8 | (uint32_t)(value < 0 ? 0 : value > 255.5f ? 255.5f : value);
+                    }
+                    out[i] = packed;
+                }
+                begin = end;
+            }
+        }
+
+        /**
+         * \brief Appends the text painted with the gradient from its first to its last character
+         *
+         * \param text UTF-8 text without escape sequences; each code point is a cell
+         * \param out Output buffer
+         * \param background Paint the background instead of the foreground
+        */
+        void render (std::string_view text, std::string& out, bool background = false) const
+        {
+            if constexpr (!enabled)
+            {
+                out += text;
+                return;
+            }
+
+            auto& cells = _cells();
+            cells.clear();
+
+            // The first cell starts at the beginning even with a stray continuation byte
+            for (std::size_t i = 0; i < text.size(); ++i)
+            {
+                if (!i || ((uint8_t)text[i] & 0xC0) != 0x80) cells.push_back((uint32_t)i);
+            }
+            auto n = cells.size();
+            if (!n) return;
+
+            auto& colors = _colors();
+            colors.resize(n);
+            sample(n, colors.data());
+
+            auto* p = _grow_buffer(out, text.size() + n * _max_rgb_escape + 5);
+
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                if (!i || ((colors[i] ^ colors[i - 1]) & _mask)) p = _write_rgb(p, colors[i], background);
+                else colors[i] = colors[i - 1];
+
+                auto end = i + 1 < n ? cells[i + 1] : (uint32_t)text.size();
+                for (auto k = cells[i]; k < end; ++k) *p++ = text[k];
+            }
+            p = _write_default_color(p, background);
+
+            out.resize((std::size_t)(p - out.data()));
+        }
+
+        /**
+         * \brief Returns the color of one of 257 evenly spaced positions
+         *
+         * \param level Position: 0 is the first stop, 256 is the last one (the middle one is exact)
+         *
+         * \return Packed color (`0xRRGGBB`)
+        */
+        [[nodiscard]]
+        auto at (unsigned level) const -> uint32_t
+        {
+            return _lut[level > 256 ? 256 : level];
+        }
+
+        /**
+         * \brief Returns the mask of the packed color bits which tell the neighbor colors apart
+        */
+        [[nodiscard]]
+        auto precision_mask () const -> uint32_t
+        {
+            return _mask;
+        }
+
+        /**
+         * \brief Returns the stops
+        */
+        [[nodiscard]]
+        auto stops () const -> std::vector<rgb> const&
+        {
+            return _stops;
+        }
+
+    private:
+
+        static auto _cells () -> std::vector<uint32_t>&
+        {
+            static thread_local std::vector<uint32_t> cells;
+            return cells;
+        }
+
+        static auto _colors () -> std::vector<uint32_t>&
+        {
+            static thread_local std::vector<uint32_t> colors;
+            return colors;
+        }
+    };
+
+    /**
+     * \class heatmap
+     *
+     * \brief Renders numeric values as cells colored by a gradient
+     *
+     * \details Values are mapped onto 257 levels of the gradient, which are computed once, so
+     * a cell takes a table lookup; the sequence is skipped where neighbor cells get the same
+     * color (with the precision of the gradient)
+    */
+    class heatmap
+    {
+        gradient _gradient;
+        double _lo, _hi;
+
+    public:
+
+        /**
+         * \brief Constructs the heatmap
+         *
+         * \param colors Gradient of the colors
+         * \param lo, hi Values which get the first and the last stops (the others are clamped)
+        */
+        heatmap (gradient colors, double lo, double hi)
+            : _gradient{ std::move(colors) }
+            , _lo{ lo }
+            , _hi{ hi }
+        {}
+
+        /**
+         * \brief Returns the packed color (`0xRRGGBB`) of the value
+        */
+        [[nodiscard]]
+        auto color (double value) const -> uint32_t
+        {
+            return _gradient.at(_level(value, _hi > _lo ? 256 / (_hi - _lo) : 0.0));
+        }
+
+        /**
+         * \brief Appends a cell per value
+         *
+         * \param values Values
+         * \param n Number of values
+         * \param out Output buffer
+         * \param glyph Text of a cell
+         * \param background Paint the background instead of the foreground
+        */
+        void render (double const* values, std::size_t n, std::string& out,
+            std::string_view glyph = "█", bool background = false) const
+        {
+            if (!n) return;
+
+            if constexpr (!enabled)
+            {
+                out.reserve(out.size() + n * glyph.size());
+                for (std::size_t i = 0; i < n; ++i) out += glyph;
+
+                return;
+            }
+
+            auto const scale = _hi > _lo ? 256 / (_hi - _lo) : 0.0;
+            auto const mask = _gradient.precision_mask();
+
+            auto* p = _grow_buffer(out, n * (glyph.size() + _max_rgb_escape) + 5);
+            auto prev = 0u;
+
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                auto c = _gradient.at(_level(values[i], scale));
+
+                if (!i || ((c ^ prev) & mask))
+                {
+                    p = _write_rgb(p, c, background);
+                    prev = c;
+                }
+                for (auto ch : glyph) *p++ = ch;
+            }
+            p = _write_default_color(p, background);
+
+            out.resize((std::size_t)(p - out.data()));
+        }
+
+        /**
+         * \brief Appends a cell per value of the container
+        */
+        template <typename Container>
+        void render (Container const& values, std::string& out, std::string_view glyph = "█", bool background = false) const
+        {
+            render(std::data(values), std::size(values), out, glyph, background);
+        }
+
+        /**
+         * \brief Returns the gradient
+        */
+        [[nodiscard]]
+        auto colors () const -> gradient const&
+        {
+            return _gradient;
+        }
+
+    private:
+
+        /// Level of the value; NaN gets the lowest one
+        auto _level (double value, double scale) const -> unsigned
+        {
+            auto t = (value - _lo) * scale + 0.5;
+            return !(t >= 0) ? 0 : t >= 256 ? 256 : (unsigned)t;
+        }
+    };
+
+}   // end namespace tesc
+
+#endif  // TESC_GRADIENT_H
+
+// MIT License
+//
+// Copyright (c) 2020-2021 Alex Qzminsky
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
@@ -0,0 +1,273 @@
+#pragma once
+
+// Copyright © 2020-2021 Alex Qzminsky.
+// License: MIT. All rights reserved.
+
+/// \brief Highlighting of search terms (`grep --color`-like)
+///
+/// \author https://github.com/qzminsky
+
+#ifndef TESC_HIGHLIGHT_H
+#define TESC_HIGHLIGHT_H
+
+#include "../tesc.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <string_view>
+#include <vector>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+namespace tesc
+{
+    /**
+     * \internal
+     * \brief Finds the first occurrence of a substring
+     *
+     * \details Candidate positions are filtered by comparing both the first and the last bytes
+     * of the needle against a whole vector of the text at once (AVX2 or SSE2, if enabled at
+     * compile time); only the positions where both bytes match are compared completely.
+     * Without the vector extensions, `std::string_view::find()` is used
+     *
+     * \param text Text to search in
+     * \param needle Non-empty substring
+     * \param from Start position
+     *
+     * \return Position of the occurrence or `std::string_view::npos`
+    */
+    [[nodiscard]]
+    inline auto _find_needle (std::string_view text, std::string_view needle, std::size_t from) -> std::size_t
+    {
+        auto const k = needle.size();
+        if (from > text.size() || text.size() - from < k) return std::string_view::npos;
+
+        if (k == 1)
+        {
+            auto* p = std::memchr(text.data() + from, needle[0], text.size() - from);
+            return p ? (std::size_t)((char const*)p - text.data()) : std::string_view::npos;
+        }
+
+        auto const* s = text.data();
+        auto i = from;
+
+        // The last position where a needle may start, plus one
+        auto const end = text.size() - k + 1;
+
+        auto verify = [&] (std::size_t pos)
+        {
+            return std::memcmp(s + pos + 1, needle.data() + 1, k - 2) == 0;
+        };
+
+    #if defined(__AVX2__)
+        auto const first = _mm256_set1_epi8(needle[0]);
+        auto const last = _mm256_set1_epi8(needle[k - 1]);
+
+        for (; i + 32 <= end; i += 32)
+        {
+            auto head = _mm256_loadu_si256((__m256i const*)(s + i));
+            auto tail = _mm256_loadu_si256((__m256i const*)(s + i + k - 1));
+
+            auto mask = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(head, first), _mm256_cmpeq_epi8(tail, last)));
+
+            for (; mask; mask &= mask - 1)
+            {
+                auto pos = i + (std::size_t)__builtin_ctz(mask);
+                if (verify(pos)) return pos;
+            }
+        }
+    #elif defined(__SSE2__)
+        auto const first = _mm_set1_epi8(needle[0]);
+        auto const last = _mm_set1_epi8(needle[k - 1]);
+
+        for (; i + 16 <= end; i += 16)
+        {
+            auto head = _mm_loadu_si128((__m128i const*)(s + i));
+            auto tail = _mm_loadu_si128((__m128i const*)(s + i + k - 1));
+
+            auto mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, last)));
+
+            for (; mask; mask &= mask - 1)
+            {
+                auto pos = i + (std::size_t)__builtin_ctz(mask);
+                if (verify(pos)) return pos;
+            }
+        }
+    #else
+        return text.find(needle, from);
+    #endif
+
+        // The remainder shorter than a vector
+        for (; i < end; ++i)
+        {
+            if (s[i] == needle[0] && s[i + k - 1] == needle[k - 1] && verify(i)) return i;
+        }
+        return std::string_view::npos;
+    }
+
+    /**
+     * \class highlighted
+     *
+     * \brief Text with highlighted occurrences of search terms, ready to be written
+     *
+     * \details Occurrences of all the terms are found lazily, one at a time per term, and
+     * overlapping or adjacent occurrences are joined into a single highlighted range. The text
+     * is written by slices of the original one, so no intermediate strings are built
+     *
+     * \note Refers to the text, which must outlive the object
+    */
+    class highlighted
+    {
+        std::string_view _text;
+        std::vector<std::string_view> _needles;
+        escape _open, _close;
+
+    public:
+
+        /**
+         * \brief Constructs the object
+         *
+         * \param text Text to highlight in
+         * \param first, last Range of search terms (empty terms are ignored)
+         * \param st Style of the highlighting
+        */
+        template <typename It>
+        highlighted (std::string_view text, It first, It last, state st)
+            : _text{ text }
+            , _open{ transition({}, st) }
+            , _close{ transition(st, {}) }
+        {
+            for (; first != last; ++first)
+            {
+                if (std::string_view needle = *first; !needle.empty()) _needles.push_back(needle);
+            }
+        }
+
+        /**
+         * \brief Writes the text to the sink
+         *
+         * \param sink Callable object taking `std::string_view` slices of the output
+        */
+        template <typename Sink>
+        void write (Sink&& sink) const
+        {
+            auto const npos = std::string_view::npos;
+
+            if (!enabled || _needles.empty())
+            {
+                sink(_text);
+                return;
+            }
+
+            // The next occurrence of each term
+            std::vector<std::size_t> next(_needles.size());
+            for (std::size_t i = 0; i < _needles.size(); ++i) next[i] = _find_needle(_text, _needles[i], 0);
+
+            for (std::size_t done = 0;;)
+            {
+                auto begin = *std::min_element(next.begin(), next.end());
+
+                if (begin == npos)
+                {
+                    if (done < _text.size()) sink(_text.substr(done));
+                    return;
+                }
+
+                // Joining all the occurrences which overlap or touch the range
+                auto end = begin;
+
+                for (auto changed = true; changed;)
+                {
+                    changed = false;
+
+                    for (std::size_t i = 0; i < _needles.size(); ++i)
+                    {
+                        for (; next[i] <= end; changed = true)
+                        {
+                            end = std::max(end, next[i] + _needles[i].size());
+                            next[i] = _find_needle(_text, _needles[i], next[i] + 1);
+                        }
+                    }
+                }
+
+                if (done < begin) sink(_text.substr(done, begin - done));
+
+                sink(_open.view());
+                sink(_text.substr(begin, end - begin));
+                sink(_close.view());
+
+                done = end;
+            }
+        }
+
+        /**
+         * \brief Writes the text to the output stream
+        */
+        friend auto operator << (std::ostream& os, highlighted const& hl) -> std::ostream&
+        {
+            hl.write([&os] (std::string_view slice) { os.write(slice.data(), (std::streamsize)slice.size()); });
+            return os;
+        }
+    };
+
+    /**
+     * \brief Highlights occurrences of the search terms in the text
+     *
+     * \param text Text to highlight in
+     * \param needles Search terms
+     * \param st Style of the highlighting
+     *
+     * \return Object to be written to a stream (`os << highlight(...)`) or to a sink (`write()`)
+    */
+    [[nodiscard]]
+    inline auto highlight (std::string_view text, std::initializer_list<std::string_view> needles, state st) -> highlighted
+    {
+        return { text, needles.begin(), needles.end(), st };
+    }
+
+    /**
+     * \brief Highlights occurrences of the search terms in the text
+     *
+     * \param text Text to highlight in
+     * \param needles Container of search terms (convertible to `std::string_view`)
+     * \param st Style of the highlighting
+     *
+     * \return Object to be written to a stream (`os << highlight(...)`) or to a sink (`write()`)
+    */
+    template <typename Container>
+    [[nodiscard]]
+    auto highlight (std::string_view text, Container const& needles, state st) -> highlighted
+    {
+        return { text, std::begin(needles), std::end(needles), st };
+    }
+
+}   // end namespace tesc
+
+#endif  // TESC_HIGHLIGHT_H
+
+// MIT License
+//
+// Copyright (c) 2020-2021 Alex Qzminsky
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
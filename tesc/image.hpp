@@ -0,0 +1,428 @@
+#pragma once
+
+// Copyright © 2020-2021 Alex Qzminsky.
+// License: MIT. All rights reserved.
+
+/// \brief PPM/PGM images drawn with half-block characters
+///
+/// \author https://github.com/qzminsky
+
+#ifndef TESC_IMAGE_H
+#define TESC_IMAGE_H
+
+#include "gradient.hpp"
+
+#include <cctype>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tesc
+{
+    /**
+     * \class image
+     *
+     * \brief Raster of 24-bit colors
+    */
+    class image
+    {
+        std::size_t _width = 0, _height = 0;
+        std::vector<uint32_t> _pixels;          ///< Row-major, packed `0xRRGGBB`
+
+    public:
+
+        /**
+         * \brief Default constructor. Makes an empty image
+        */
+        image () = default;
+
+        /**
+         * \brief Makes the image of a single color
+         *
+         * \param width, height Size in pixels
+         * \param fill Color of the pixels
+        */
+        image (std::size_t width, std::size_t height, rgb fill = {})
+            : _width{ width }
+            , _height{ height }
+            , _pixels(width * height, fill.hex())
+        {}
+
+        /**
+         * \brief Returns the width in pixels
+        */
+        [[nodiscard]]
+        auto width () const -> std::size_t
+        {
+            return _width;
+        }
+
+        /**
+         * \brief Returns the height in pixels
+        */
+        [[nodiscard]]
+        auto height () const -> std::size_t
+        {
+            return _height;
+        }
+
+        /**
+         * \brief Returns the color of the pixel
+        */
+        [[nodiscard]]
+        auto at (std::size_t x, std::size_t y) const -> rgb
+        {
+            return rgb::from_hex(_pixels[y * _width + x]);
+        }
+
+        /**
+         * \brief Sets the color of the pixel
+        */
+        void set (std::size_t x, std::size_t y, rgb color)
+        {
+            _pixels[y * _width + x] = color.hex();
+        }
+
+        /**
+         * \brief Returns the packed colors (`0xRRGGBB`) of the row
+        */
+        [[nodiscard]]
+        auto row (std::size_t y) const -> uint32_t const*
+        {
+            return _pixels.data() + y * _width;
+        }
+    };
+
+    /**
+     * \enum color_depth
+     *
+     * \brief Colors which the terminal supports
+    */
+    enum class color_depth : uint8_t
+    {
+        basic,          ///< 16 colors of `face` and `back`
+        truecolor,      ///< 24-bit colors
+    };
+
+    /**
+     * \brief Finds the nearest colors of `xterm_palette` for an array of colors
+     *
+     * \details Distances to the 16 colors are computed for four pixels at once (SSE2, if
+     * enabled at compile time); the result is the same as of `nearest_basic(rgb)`
+     *
+     * \param colors Packed colors (`0xRRGGBB`)
+     * \param n Number of colors
+     * \param out Indices in `xterm_palette`, `n` of them
+    */
+    inline void nearest_basic (uint32_t const* colors, std::size_t n, uint8_t* out)
+    {
+        std::size_t i = 0;
+
+    #if defined(__SSE2__)
+        // Pixels are kept as 16-bit pairs (r, g) and (b, 0): a single `madd` squares and sums them
+        __m128i red_green[16], blue[16];
+
+        for (auto k = 0; k < 16; ++k)
+        {
+            red_green[k] = _mm_set1_epi32(xterm_palette[k].r | xterm_palette[k].g << 16);
+            blue[k] = _mm_set1_epi32(xterm_palette[k].b);
+        }
+        auto const byte = _mm_set1_epi32(0xFF);
+
+        for (; i + 4 <= n; i += 4)
+        {
+            auto px = _mm_loadu_si128((__m128i const*)(colors + i));
+
+            auto rg = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(px, 16), byte), _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(px, 8), byte), 16));
+            auto b = _mm_and_si128(px, byte);
+
+            auto best = _mm_set1_epi32(INT_MAX);
+            auto index = _mm_setzero_si128();
+
+            for (auto k = 0; k < 16; ++k)
+            {
+                auto d1 = _mm_sub_epi16(rg, red_green[k]);
+                auto d2 = _mm_sub_epi16(b, blue[k]);
+                auto distance = _mm_add_epi32(_mm_madd_epi16(d1, d1), _mm_madd_epi16(d2, d2));
+
+                // Strictly less: ties go to the first color, as in the scalar search
+                auto less = _mm_cmplt_epi32(distance, best);
+
+                best = _mm_or_si128(_mm_and_si128(less, distance), _mm_andnot_si128(less, best));
+                index = _mm_or_si128(_mm_and_si128(less, _mm_set1_epi32(k)), _mm_andnot_si128(less, index));
+            }
+            auto bytes = _mm_packus_epi16(_mm_packs_epi32(index, index), index);
+            auto packed = _mm_cvtsi128_si32(bytes);
+
+            std::memcpy(out + i, &packed, 4);
+        }
+    #endif
+
+        for (; i < n; ++i) out[i] = (uint8_t)nearest_basic(rgb::from_hex(colors[i]));
+    }
+
+    /**
+     * \brief Parses a PPM (`P3`, `P6`) or PGM (`P2`, `P5`) image
+     *
+     * \param data Contents of the file
+     *
+     * \return Image; samples of a maximal value other than 255 are rescaled
+     *
+     * \throw std::invalid_argument if the data is malformed or truncated
+    */
+    [[nodiscard]]
+    inline auto parse_pnm (std::string_view data) -> image
+    {
+        auto fail = [] (char const* what) -> void {
+            throw std::invalid_argument{ std::string{ "tesc::parse_pnm: " } + what };
+        };
+
+        if (data.size() < 2 || data[0] != 'P' || data[1] < '2' || data[1] > '6' || data[1] == '4') fail("unsupported format");
+
+        auto const kind = data[1];
+        auto const gray = kind == '2' || kind == '5';
+        auto const binary = kind >= '5';
+
+        std::size_t pos = 2;
+
+        auto skip = [&]
+        {
+            while (pos < data.size())
+            {
+                if (data[pos] == '#') while (pos < data.size() && data[pos] != '\n') ++pos;
+                else if (std::isspace((unsigned char)data[pos])) ++pos;
+                else break;
+            }
+        };
+
+        auto number = [&] () -> std::size_t
+        {
+            skip();
+            if (pos >= data.size() || !std::isdigit((unsigned char)data[pos])) fail("a number expected");
+
+            std::size_t value = 0;
+            for (; pos < data.size() && std::isdigit((unsigned char)data[pos]); ++pos)
+            {
+                value = value * 10 + (std::size_t)(data[pos] - '0');
+                if (value > 1 << 24) fail("a number is too large");
+            }
+            return value;
+        };
+
+        auto width = number(), height = number(), max = number();
+
+        if (!max || max > 65535) fail("invalid maximal value");
+        if (width * height > 1 << 26) fail("the image is too large");
+
+        // A single whitespace separates the header from the binary samples
+        if (binary && ++pos > data.size()) fail("truncated data");
+
+        auto const channels = gray ? 1u : 3u;
+        auto const wide = max > 255;
+
+        if (binary && data.size() - pos < width * height * channels * (wide ? 2 : 1)) fail("truncated data");
+
+        auto sample = [&] () -> uint32_t
+        {
+            std::size_t value;
+
+            if (!binary) value = number();
+            else if (!wide) value = (uint8_t)data[pos++];
+            else
+            {
+                value = (std::size_t)(uint8_t)data[pos] << 8 | (uint8_t)data[pos + 1];
+                pos += 2;
+            }
+            if (value > max) value = max;
+
+            return max == 255 ? (uint32_t)value : (uint32_t)((value * 255 + max / 2) / max);
+        };
+
+        image img{ width, height };
+
+        for (std::size_t y = 0; y < height; ++y)
+        {
+            for (std::size_t x = 0; x < width; ++x)
+            {
+                if (gray)
+                {
+                    auto v = (uint8_t)sample();
+                    img.set(x, y, { v, v, v });
+                }
+                else
+                {
+                    auto r = (uint8_t)sample(), g = (uint8_t)sample(), b = (uint8_t)sample();
+                    img.set(x, y, { r, g, b });
+                }
+            }
+        }
+        return img;
+    }
+
+    /**
+     * \brief Reads and parses a PPM or PGM image file
+     *
+     * \param path Path of the file
+     *
+     * \throw std::runtime_error if the file cannot be read
+     * \throw std::invalid_argument if the file is malformed
+    */
+    [[nodiscard]]
+    inline auto load_pnm (std::string const& path) -> image
+    {
+        std::ifstream file{ path, std::ios::binary };
+        if (!file) throw std::runtime_error{ "tesc::load_pnm: cannot open '" + path + "'" };
+
+        std::ostringstream data;
+        data << file.rdbuf();
+
+        return parse_pnm(data.str());
+    }
+
+    /**
+     * \internal
+     * \brief Writes the parameter of the color of a cell side
+     *
+     * \param color Packed color, an index in `xterm_palette` or `~0u` for the default color
+    */
+    inline auto _write_cell_color (char* p, uint32_t color, bool background, color_depth depth) -> char*
+    {
+        auto put = [&p] (unsigned value)
+        {
+            auto& t = _byte_texts[value];
+            for (std::size_t i = 0; i < t.size; ++i) *p++ = t.text[i];
+        };
+
+        if (color == ~0u) put(background ? 49 : 39);
+        else if (depth == color_depth::basic) put((background ? 40 : 30) + (color < 8 ? color : color + 52));
+        else
+        {
+            put(background ? 48 : 38);
+            *p++ = ';'; *p++ = '2';
+
+            for (auto shift : { 16, 8, 0 })
+            {
+                *p++ = ';';
+                put((color >> shift) & 0xFF);
+            }
+        }
+        return p;
+    }
+
+    /**
+     * \brief Appends the image drawn with `▀`: each character shows two pixels, the upper one
+     * by the foreground and the lower one by the background
+     *
+     * \details Sequences are written only where a color changes, and both colors of a cell
+     * go in a single sequence. Cells of a single color are drawn with a space or `█`, which
+     * need one of the colors only. Colors are reset at the end of every line
+     *
+     * \param img Image
+     * \param out Output buffer
+     * \param depth Colors to use; basic ones are the nearest colors of `xterm_palette`
+    */
+    inline void render_image (image const& img, std::string& out, color_depth depth = color_depth::truecolor)
+    {
+        auto const width = img.width();
+        auto const none = ~0u;
+
+        std::vector<uint32_t> upper(width), lower(width);
+        std::vector<uint8_t> indices(width);
+
+        auto load = [&] (std::size_t y, std::vector<uint32_t>& cells)
+        {
+            if (y >= img.height()) return (void)cells.assign(width, none);
+            if (depth == color_depth::truecolor) return (void)cells.assign(img.row(y), img.row(y) + width);
+
+            nearest_basic(img.row(y), width, indices.data());
+            cells.assign(indices.begin(), indices.end());
+        };
+
+        for (std::size_t y = 0; y < img.height(); y += 2)
+        {
+            load(y, upper);
+            load(y + 1, lower);
+
+            // Two sequences and a glyph per cell at most, and the reset
+            auto* p = _grow_buffer(out, width * (2 * _max_rgb_escape + 3) + 16);
+            auto fg = none, bg = none;
+
+            for (std::size_t x = 0; x < width; ++x)
+            {
+                auto top = upper[x], bottom = lower[x];
+
+                // A cell of a single color needs one of the colors only
+                if (top == bottom && enabled)
+                {
+                    if (fg == top) { p = (char*)std::memcpy(p, "█", 3) + 3; continue; }
+                    if (bg != top)
+                    {
+                        *p++ = '\033'; *p++ = '[';
+                        p = _write_cell_color(p, top, true, depth);
+                        *p++ = 'm';
+                        bg = top;
+                    }
+                    *p++ = ' ';
+                    continue;
+                }
+
+                if (enabled && (top != fg || bottom != bg))
+                {
+                    *p++ = '\033'; *p++ = '[';
+
+                    if (top != fg) p = _write_cell_color(p, top, false, depth);
+                    if (top != fg && bottom != bg) *p++ = ';';
+                    if (bottom != bg) p = _write_cell_color(p, bottom, true, depth);
+
+                    *p++ = 'm';
+                    fg = top, bg = bottom;
+                }
+                p = (char*)std::memcpy(p, "▀", 3) + 3;
+            }
+
+            if (fg != none || bg != none)
+            {
+                *p++ = '\033'; *p++ = '[';
+
+                if (fg != none) p = _write_cell_color(p, none, false, depth);
+                if (fg != none && bg != none) *p++ = ';';
+                if (bg != none) p = _write_cell_color(p, none, true, depth);
+
+                *p++ = 'm';
+            }
+            *p++ = '\n';
+
+            out.resize((std::size_t)(p - out.data()));
+        }
+    }
+
+}   // end namespace tesc
+
+#endif  // TESC_IMAGE_H
+
+// MIT License
+//
+// Copyright (c) 2020-2021 Alex Qzminsky
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
@@ -0,0 +1,314 @@
+#pragma once
+
+// Copyright © 2020-2021 Alex Qzminsky.
+// License: MIT. All rights reserved.
+
+/// \brief Frame-rate limited live region at the bottom of the terminal
+///
+/// \author https://github.com/qzminsky
+
+#ifndef TESC_LIVE_H
+#define TESC_LIVE_H
+
+#include "../tesc.hpp"
+
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tesc
+{
+    /**
+     * \class live_region
+     *
+     * \brief Owner of the bottom lines of the terminal which coalesces their updates into frames
+     *
+     * \details Widgets (spinners, ETA, throughput...) only replace the text of their lines.
+     * A scheduler thread collects all the changes made during a tick and writes them at once,
+     * as a single frame wrapped in the synchronized output mode (DEC 2026) so that the terminal
+     * never shows a half-drawn frame. When nothing changes, the thread sleeps without a timeout
+     *
+     * \note Line texts may contain escape sequences but must not contain line breaks
+    */
+    class live_region
+    {
+        using clock = std::chrono::steady_clock;
+
+        std::ostream& _os;
+        clock::duration _tick;
+        bool _sync;
+
+        std::mutex _mutex;
+        std::condition_variable _wakeup;
+        std::vector<std::string> _lines;        ///< Pending texts of the region lines
+        std::vector<bool> _dirty;
+        std::string _above;                     ///< Pending lines to be printed above the region
+        bool _changed = false;
+        bool _stopping = false;
+
+        std::thread _scheduler;
+        std::vector<std::string> _shown;        ///< Texts on the screen (scheduler-side)
+        std::string _frame_buffer;
+        bool _reserved = false;
+
+    public:
+
+        /**
+         * \brief Constructs a region
+         *
+         * \param os Output stream of the terminal
+         * \param lines Number of lines in the region
+         * \param tick Minimal interval between frames
+         * \param sync Whether to wrap frames in the synchronized output mode
+        */
+        live_region (std::ostream& os, std::size_t lines, std::chrono::milliseconds tick = std::chrono::milliseconds{ 33 }, bool sync = true)
+            : _os{ os }
+            , _tick{ tick }
+            , _sync{ sync }
+            , _lines(lines)
+            , _dirty(lines, true)
+            , _shown(lines)
+        {}
+
+        /// The scheduler thread refers to the object
+        live_region (live_region const&) = delete;
+        auto operator = (live_region const&) -> live_region& = delete;
+
+        /**
+         * \brief Destructor. Draws the final frame and leaves the cursor below the region
+        */
+        ~live_region ()
+        {
+            stop();
+        }
+
+        /**
+         * \brief Returns the number of lines in the region
+        */
+        [[nodiscard]]
+        auto size () const -> std::size_t
+        {
+            return _shown.size();
+        }
+
+        /**
+         * \brief Replaces the text of a region line; it will be drawn by the next frame
+         *
+         * \param index Line index (zero is the top line)
+         * \param text New text
+        */
+        void update (std::size_t index, std::string_view text)
+        {
+            {
+                std::lock_guard lock{ _mutex };
+                if (_lines.at(index) == text) return;
+
+                _lines[index].assign(text);
+                _dirty[index] = true;
+                _changed = true;
+            }
+            _wakeup.notify_one();
+        }
+
+        /**
+         * \brief Prints a line above the region, so that it goes to the scrollback
+         *
+         * \param text Line text
+        */
+        void print (std::string_view text)
+        {
+            {
+                std::lock_guard lock{ _mutex };
+
+                _above.append(text);
+                _above += '\n';
+                _changed = true;
+            }
+            _wakeup.notify_one();
+        }
+
+        /**
+         * \brief Launches the scheduler thread
+        */
+        void start ()
+        {
+            if (_scheduler.joinable()) return;
+
+            _stopping = false;
+            _scheduler = std::thread{ [this] { _run(); } };
+        }
+
+        /**
+         * \brief Draws the final frame, leaves the region and joins the scheduler thread
+        */
+        void stop ()
+        {
+            if (_scheduler.joinable())
+            {
+                {
+                    std::lock_guard lock{ _mutex };
+                    _stopping = true;
+                }
+                _wakeup.notify_one();
+                _scheduler.join();
+            }
+            if (_reserved)
+            {
+                // Moving the cursor below the region: it is not ours anymore
+                _frame_buffer.clear();
+                _move_lines((long)size());
+                _frame_buffer += '\r';
+                _os.write(_frame_buffer.data(), (std::streamsize)_frame_buffer.size()).flush();
+
+                _reserved = false;
+            }
+        }
+
+        /**
+         * \brief Draws pending changes immediately (for the use without the scheduler thread)
+        */
+        void render ()
+        {
+            std::vector<std::string> lines;
+            std::vector<bool> dirty;
+            std::string above;
+
+            if (_collect(lines, dirty, above)) _render_frame(lines, dirty, above);
+        }
+
+    private:
+
+        void _run ()
+        {
+            auto next_frame = clock::now();
+
+            for (;;)
+            {
+                {
+                    std::unique_lock lock{ _mutex };
+
+                    // Sleeping until anything changes...
+                    _wakeup.wait(lock, [this] { return _changed || _stopping; });
+
+                    // ...and then until the frame deadline, collecting other changes of this tick
+                    _wakeup.wait_until(lock, next_frame, [this] { return _stopping; });
+                }
+                render();
+
+                if (std::lock_guard lock{ _mutex }; _stopping) return;
+                next_frame = clock::now() + _tick;
+            }
+        }
+
+        /**
+         * \brief Takes pending changes under the lock
+         *
+         * \return `false` if there are no changes
+        */
+        auto _collect (std::vector<std::string>& lines, std::vector<bool>& dirty, std::string& above) -> bool
+        {
+            std::lock_guard lock{ _mutex };
+            if (!_changed) return false;
+
+            lines.resize(_lines.size());
+            for (std::size_t i = 0; i < _lines.size(); ++i)
+            {
+                if (_dirty[i]) lines[i] = _lines[i];
+            }
+            dirty.swap(_dirty);
+            _dirty.assign(dirty.size(), false);
+            above.swap(_above);
+            _changed = false;
+
+            return true;
+        }
+
+        void _render_frame (std::vector<std::string>& lines, std::vector<bool> const& dirty, std::string const& above)
+        {
+            _frame_buffer.clear();
+            if (_sync) _frame_buffer += "\033[?2026h";
+
+            if (!_reserved)
+            {
+                // Reserving the region lines and returning to the top of them
+                _frame_buffer.append(size(), '\n');
+                _move_lines(-(long)size());
+                _reserved = true;
+            }
+
+            // The cursor is at the beginning of the region top line between frames
+            long cursor = 0;
+            auto redraw_all = !above.empty();
+
+            if (redraw_all)
+            {
+                // The printed lines push the region down by scrolling the screen
+                _frame_buffer += "\033[J";
+                _frame_buffer += above;
+                _frame_buffer.append(size(), '\n');
+                _move_lines(-(long)size());
+            }
+
+            for (std::size_t i = 0; i < size(); ++i)
+            {
+                if (dirty[i]) _shown[i].swap(lines[i]);
+                else if (!redraw_all) continue;
+
+                _move_lines((long)i - cursor);
+                cursor = (long)i;
+
+                _frame_buffer += '\r';
+                _frame_buffer += _shown[i];
+                if constexpr (enabled) _frame_buffer += reset_escape;
+                _frame_buffer += "\033[K";
+            }
+
+            _move_lines(-cursor);
+            _frame_buffer += '\r';
+
+            if (_sync) _frame_buffer += "\033[?2026l";
+            _os.write(_frame_buffer.data(), (std::streamsize)_frame_buffer.size()).flush();
+        }
+
+        void _move_lines (long delta)
+        {
+            if (!delta) return;
+
+            char text[16];
+            auto* p = std::to_chars(text, text + sizeof text, delta < 0 ? -delta : delta).ptr;
+
+            _frame_buffer += "\033[";
+            _frame_buffer.append(text, p);
+            _frame_buffer += delta < 0 ? 'A' : 'B';
+        }
+    };
+
+}   // end namespace tesc
+
+#endif  // TESC_LIVE_H
+
+// MIT License
+//
+// Copyright (c) 2020-2021 Alex Qzminsky
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
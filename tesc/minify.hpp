@@ -0,0 +1,349 @@
+#pragma once
+
+// Copyright © 2020-2021 Alex Qzminsky.
+// License: MIT. All rights reserved.
+
+/// \brief Minification of SGR sequences in captured or generated output
+///
+/// \author https://github.com/qzminsky
+
+#ifndef TESC_MINIFY_H
+#define TESC_MINIFY_H
+
+#include "../tesc.hpp"
+#include "ansi.hpp"
+
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace tesc
+{
+    /**
+     * \class sgr_minifier
+     *
+     * \brief Streaming rewriter of SGR sequences into the minimal equivalent ones
+     *
+     * \details SGR sequences are not written as they come: they only change the desired state.
+     * Before anything else is written (text, controls, other sequences), the shortest transition
+     * from the state of the terminal to the desired one is emitted (see `transition()`). Thus
+     * back-to-back sequences are merged, no-ops are dropped, and resets followed by colors turn
+     * into deltas. SGR attributes which `state` can't represent (e.g. 256 colors) are passed
+     * as is, and the sequences are not rewritten until the next full reset
+    */
+    class sgr_minifier
+    {
+        static constexpr std::size_t _max_partial = 4096;
+
+        state _actual;                          ///< State of the terminal
+        state _desired;                         ///< State requested by the input
+        bool _opaque = false;                   ///< Unknown attributes may be active
+        std::string _partial;                   ///< Incomplete sequence from the previous input
+
+    public:
+
+        /**
+         * \brief Rewrites the next part of the input
+         *
+         * \param in Input bytes; sequences may be split between the calls
+         * \param out Output buffer
+        */
+        void feed (std::string_view in, std::string& out)
+        {
+            if (!_partial.empty())
+            {
+                // Completing the sequence byte by byte
+                while (!in.empty())
+                {
+                    _partial += in.front();
+                    in.remove_prefix(1);
+
+                    if (sequence_length(_partial, 0) != std::string_view::npos || _partial.size() >= _max_partial) break;
+                }
+                if (sequence_length(_partial, 0) == std::string_view::npos && _partial.size() < _max_partial) return;
+
+                _sequence(_partial, out);
+                _partial.clear();
+            }
+
+            for (std::size_t pos = 0; pos < in.size();)
+            {
+                auto const* esc = (char const*)std::memchr(in.data() + pos, '\033', in.size() - pos);
+                auto start = esc ? (std::size_t)(esc - in.data()) : in.size();
+
+                if (start > pos)
+                {
+                    _apply(out);
+                    out.append(in.data() + pos, start - pos);
+                }
+                if (!esc) return;
+
+                auto len = sequence_length(in, start);
+                if (len == std::string_view::npos)
+                {
+                    _partial.assign(in.substr(start));
+                    return;
+                }
+
+                _sequence(in.substr(start, len), out);
+                pos = start + len;
+            }
+        }
+
+        /**
+         * \brief Writes the pending state change; an incomplete sequence is kept
+         *
+         * \param out Output buffer
+        */
+        void flush (std::string& out)
+        {
+            _apply(out);
+        }
+
+        /**
+         * \brief Writes the pending state change and an incomplete sequence, if any
+         *
+         * \param out Output buffer
+        */
+        void finish (std::string& out)
+        {
+            _apply(out);
+
+            out += _partial;
+            _partial.clear();
+        }
+
+        /**
+         * \brief Forgets the state of the stream (e.g. when the terminal is reset externally)
+        */
+        void clear ()
+        {
+            _actual = _desired = {};
+            _opaque = false;
+            _partial.clear();
+        }
+
+    private:
+
+        void _apply (std::string& out)
+        {
+            if (_desired == _actual) return;
+
+            auto delta = transition(_actual, _desired);
+            auto fresh = transition({}, _desired);
+
+            // Resetting first (`ESC [0;...m`) may be shorter than the delta
+            if (_desired != state{} && fresh.size() + 2 < delta.size())
+            {
+                out.append(fresh.view().substr(0, 2)).append("0;").append(fresh.view().substr(2));
+            }
+            else out += delta.view();
+
+            _actual = _desired;
+        }
+
+        void _sequence (std::string_view seq, std::string& out)
+        {
+            auto sgr = seq.size() >= 3 && seq[1] == '[' && seq.back() == 'm';
+
+            if (!sgr)
+            {
+                _apply(out);
+                out += seq;
+                return;
+            }
+
+            auto fg = _desired.get_face();
+            auto bg = _desired.get_back();
+            auto st = (uint8_t)_desired.get_style();
+            auto known = true;
+            auto full_reset = false;
+            auto skip = 0;                      // Arguments of an extended color left
+
+            // Parameters between `ESC [` and `m`; an empty one stands for zero
+            for (auto params = seq.substr(2, seq.size() - 3); ;)
+            {
+                auto end = params.find(';');
+                auto param = params.substr(0, end);
+                unsigned p = 0;
+
+                for (auto ch : param)
+                {
+                    if (ch < '0' || ch > '9' || p > 1000) known = false;
+                    else p = p * 10 + (unsigned)(ch - '0');
+                }
+
+                if (skip < 0) skip = p == 5 ? 1 : p == 2 ? 3 : 0;
+                else if (skip > 0) --skip;
+                else switch (p)
+                {
+                case 0: fg = face::none; bg = back::none; st = 0; full_reset = true; break;
+                case 1: st |= (uint8_t)style::bold; break;
+                case 3: st |= (uint8_t)style::italic; break;
+                case 4: st |= (uint8_t)style::underline; break;
+                case 22: st &= (uint8_t)~(uint8_t)style::bold; break;
+                case 23: st &= (uint8_t)~(uint8_t)style::italic; break;
+                case 24: st &= (uint8_t)~(uint8_t)style::underline; break;
+                case 39: fg = face::none; break;
+                case 49: bg = back::none; break;
+
+                case 38: case 48:
+                    // Extended colors can't be represented: skipping their arguments
+                    known = false;
+                    skip = -1;
+                    break;
+
+                default:
+                    if ((p >= 30 && p <= 37) || (p >= 90 && p <= 97)) fg = face{ (uint8_t)p };
+                    else if ((p >= 40 && p <= 47) || (p >= 100 && p <= 107)) bg = back{ (uint8_t)p };
+                    else known = false;
+                }
+
+                if (end == std::string_view::npos) break;
+                params.remove_prefix(end + 1);
+            }
+
+            if (!known || _opaque)
+            {
+                // The sequence can't be rewritten: the terminal gets it as is
+                _apply(out);
+                out += seq;
+
+                _desired = _actual = state{ fg, bg, style{ st } };
+                _opaque = !known || (_opaque && !full_reset);
+                return;
+            }
+            _desired = state{ fg, bg, style{ st } };
+        }
+    };
+
+    /**
+     * \brief Rewrites SGR sequences of the buffer into the minimal equivalent ones
+     *
+     * \param in Input text
+     *
+     * \return Rewritten text
+    */
+    [[nodiscard]]
+    inline auto minify_sgr (std::string_view in) -> std::string
+    {
+        std::string out;
+        out.reserve(in.size());
+
+        sgr_minifier minifier;
+        minifier.feed(in, out);
+        minifier.finish(out);
+
+        return out;
+    }
+
+    /**
+     * \class minifying_buffer
+     *
+     * \brief Stream buffer which minifies SGR sequences on the way to the target one
+     *
+     * \details Written bytes are collected and rewritten by blocks; the pending state change
+     * is written on each flush, so the terminal state is right whenever the output is visible
+    */
+    class minifying_buffer : public std::streambuf
+    {
+        std::streambuf* _target;
+        sgr_minifier _minifier;
+        std::string _out;
+        char _area[4096];
+
+    public:
+
+        /**
+         * \brief Constructs the buffer
+         *
+         * \param target Stream buffer to write the rewritten output to
+        */
+        explicit minifying_buffer (std::streambuf* target) : _target{ target }
+        {
+            setp(_area, _area + sizeof _area);
+        }
+
+        /// The put area refers to the object
+        minifying_buffer (minifying_buffer const&) = delete;
+        auto operator = (minifying_buffer const&) -> minifying_buffer& = delete;
+
+        /**
+         * \brief Destructor. Writes the pending output
+        */
+        ~minifying_buffer () override
+        {
+            _feed();
+            _minifier.finish(_out);
+
+            _write();
+            _target->pubsync();
+        }
+
+    protected:
+
+        auto overflow (int_type ch) -> int_type override
+        {
+            _feed();
+
+            // The pending state change waits for the next bytes
+            if (!_write()) return traits_type::eof();
+            if (traits_type::eq_int_type(ch, traits_type::eof())) return traits_type::not_eof(ch);
+
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+
+            return ch;
+        }
+
+        auto sync () -> int override
+        {
+            _feed();
+            _minifier.flush(_out);
+
+            return _write() ? _target->pubsync() : -1;
+        }
+
+    private:
+
+        void _feed ()
+        {
+            _minifier.feed({ pbase(), (std::size_t)(pptr() - pbase()) }, _out);
+            setp(_area, _area + sizeof _area);
+        }
+
+        auto _write () -> bool
+        {
+            auto n = (std::streamsize)_out.size();
+            auto res = n ? _target->sputn(_out.data(), n) : 0;
+            _out.clear();
+
+            return res == n;
+        }
+    };
+
+}   // end namespace tesc
+
+#endif  // TESC_MINIFY_H
+
+// MIT License
+//
+// Copyright (c) 2020-2021 Alex Qzminsky
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
@@ -0,0 +1,192 @@
+#pragma once
+
+// Copyright © 2020-2021 Alex Qzminsky.
+// License: MIT. All rights reserved.
+
+/// \brief Per-line style painting and delta-minimized emission
+///
+/// \author https://github.com/qzminsky
+
+#ifndef TESC_PAINT_H
+#define TESC_PAINT_H
+
+#include "../tesc.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace tesc
+{
+    /**
+     * \brief Parses a textual style specification
+     *
+     * \details The specification is a list of words separated by spaces, commas or `+`:
+     * color names (`red`, `bright-red`), background color names (`on-blue`, `on-bright-blue`)
+     * and font styles (`bold`, `italic`, `underline`, `normal`)
+     *
+     * \param spec Style specification, e.g. `"bright-white on-red bold"`
+     *
+     * \return Parsed state or `std::nullopt` if there are unknown words
+    */
+    [[nodiscard]]
+    inline auto parse_state (std::string_view spec) -> std::optional<state>
+    {
+        constexpr std::string_view colors[] = {
+            "black", "red", "green", "yellow", "blue", "magenta", "cyan", "white",
+        };
+
+        auto fg = face::none;
+        auto bg = back::none;
+        auto st = style::normal;
+
+        while (!spec.empty())
+        {
+            auto end = spec.find_first_of(" \t,+");
+            auto word = spec.substr(0, end);
+            spec.remove_prefix(end == spec.npos ? spec.size() : end + 1);
+
+            if (word.empty()) continue;
+
+            if (word == "bold") { st = st | style::bold; continue; }
+            if (word == "italic") { st = st | style::italic; continue; }
+            if (word == "underline") { st = st | style::underline; continue; }
+            if (word == "normal") { st = style::normal; continue; }
+
+            auto on = word.substr(0, 3) == "on-";
+            if (on) word.remove_prefix(3);
+
+            auto brighter = word.substr(0, 7) == "bright-";
+            if (brighter) word.remove_prefix(7);
+
+            auto it = std::find(std::begin(colors), std::end(colors), word);
+            if (it == std::end(colors)) return std::nullopt;
+
+            auto code = (uint8_t)(it - std::begin(colors)) + (brighter ? 60 : 0);
+
+            if (on) bg = back{ (uint8_t)(40 + code) };
+            else fg = face{ (uint8_t)(30 + code) };
+        }
+        return state{ fg, bg, st };
+    }
+
+    /**
+     * \class painter
+     *
+     * \brief Canvas of style assignments for a single line of text
+     *
+     * \details Highlighters paint byte ranges with registered styles (later paints take
+     * precedence), and then the line is emitted as runs of equal style, with the shortest
+     * escape sequences between them and a return to the default style at the end
+    */
+    class painter
+    {
+        std::vector<state> _palette{ state{} };     ///< Identifier 0 stands for the default style
+        std::vector<uint16_t> _canvas;
+
+    public:
+
+        /**
+         * \brief Registers a style
+         *
+         * \param st Style
+         *
+         * \return Identifier to paint with
+        */
+        auto add_style (state st) -> uint16_t
+        {
+            _palette.push_back(st);
+            return (uint16_t)(_palette.size() - 1);
+        }
+
+        /**
+         * \brief Returns a registered style
+        */
+        [[nodiscard]]
+        auto get_style (uint16_t id) const -> state
+        {
+            return _palette.at(id);
+        }
+
+        /**
+         * \brief Clears the canvas for a new line
+         *
+         * \param length Line length in bytes
+        */
+        void begin (std::size_t length)
+        {
+            _canvas.assign(length, 0);
+        }
+
+        /**
+         * \brief Assigns a style to a byte range
+         *
+         * \param first, last Range of bytes
+         * \param id Style identifier
+        */
+        void paint (std::size_t first, std::size_t last, uint16_t id)
+        {
+            last = std::min(last, _canvas.size());
+            if (first < last) std::fill(_canvas.begin() + (std::ptrdiff_t)first, _canvas.begin() + (std::ptrdiff_t)last, id);
+        }
+
+        /**
+         * \brief Appends the painted line to the buffer
+         *
+         * \param out Output buffer
+         * \param line Line text (of the length passed to `begin()`)
+        */
+        void emit (std::string& out, std::string_view line) const
+        {
+            if constexpr (!enabled)
+            {
+                out += line;
+                return;
+            }
+
+            state pen;
+
+            for (std::size_t i = 0; i < line.size();)
+            {
+                auto id = i < _canvas.size() ? _canvas[i] : 0;
+                auto j = i + 1;
+
+                while (j < line.size() && (j < _canvas.size() ? _canvas[j] : 0) == id) ++j;
+
+                auto next = _palette[id];
+                out += transition(pen, next).view();
+                out.append(line.data() + i, j - i);
+
+                pen = next;
+                i = j;
+            }
+            out += transition(pen, {}).view();
+        }
+    };
+
+}   // end namespace tesc
+
+#endif  // TESC_PAINT_H
+
+// MIT License
+//
+// Copyright (c) 2020-2021 Alex Qzminsky
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
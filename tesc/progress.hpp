@@ -0,0 +1,394 @@
+#pragma once
+
+// Copyright © 2020-2021 Alex Qzminsky.
+// License: MIT. All rights reserved.
+
+/// \brief Multi-bar progress renderer with lock-free updates
+///
+/// \author https://github.com/qzminsky
+
+#ifndef TESC_PROGRESS_H
+#define TESC_PROGRESS_H
+
+#include "../tesc.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tesc
+{
+    /**
+     * \class progress
+     *
+     * \brief Set of progress bars redrawn by a single renderer thread
+     *
+     * \details Workers only bump atomic counters of their bars and never write to the terminal.
+     * The renderer wakes up at a capped frame rate and redraws only the bars which changed:
+     * it moves the cursor to the line, appends the newly filled cells and rewrites the numbers,
+     * switching colors only when they differ from the current ones
+     *
+     * \note Bar labels are expected to be single-byte (ASCII) strings
+    */
+    class progress
+    {
+    public:
+
+        /**
+         * \class bar
+         *
+         * \brief Worker-side handle of a single progress bar
+        */
+        class alignas(64) bar
+        {
+            std::atomic<uint64_t> _done{ 0 };
+            std::atomic<uint64_t> _total;
+
+            // Renderer-side data: nobody but the renderer touches it
+            std::string _label;
+            face _color;
+            unsigned _shown_cells = 0;
+            int _shown_percent = -1;
+            uint64_t _shown_done = ~uint64_t{};
+            uint64_t _shown_total = ~uint64_t{};
+
+            friend class progress;
+
+        public:
+
+            /**
+             * \brief Constructs a bar
+             *
+             * \param label Text before the bar
+             * \param total Number of work items
+             * \param clr Color of the filled cells
+            */
+            bar (std::string label, uint64_t total, face clr)
+                : _total{ total }
+                , _label{ std::move(label) }
+                , _color{ clr }
+            {}
+
+            /**
+             * \brief Marks `n` more work items as done
+            */
+            void advance (uint64_t n = 1) noexcept
+            {
+                _done.fetch_add(n, std::memory_order_relaxed);
+            }
+
+            /**
+             * \brief Sets the number of done work items
+            */
+            void set (uint64_t done) noexcept
+            {
+                _done.store(done, std::memory_order_relaxed);
+            }
+
+            /**
+             * \brief Changes the number of work items
+            */
+            void set_total (uint64_t total) noexcept
+            {
+                _total.store(total, std::memory_order_relaxed);
+            }
+
+            /**
+             * \brief Returns the number of done work items
+            */
+            [[nodiscard]]
+            auto done () const noexcept -> uint64_t
+            {
+                return _done.load(std::memory_order_relaxed);
+            }
+
+            /**
+             * \brief Returns the number of work items
+            */
+            [[nodiscard]]
+            auto total () const noexcept -> uint64_t
+            {
+                return _total.load(std::memory_order_relaxed);
+            }
+        };
+
+    private:
+
+        std::ostream& _os;
+        std::chrono::milliseconds _frame;
+        unsigned _width;
+
+        std::mutex _mutex;                      ///< Guards the bars list (never taken by workers)
+        std::condition_variable _wakeup;
+        std::vector<std::unique_ptr<bar>> _bars;
+        std::size_t _shown_bars = 0;            ///< Number of lines already on the screen
+        std::size_t _label_width = 0;
+        bool _stopping = false;
+
+        std::thread _renderer;
+        std::string _frame_buffer;
+        face _pen = face::none;                 ///< Color the terminal currently uses
+
+    public:
+
+        /**
+         * \brief Constructs a renderer
+         *
+         * \param os Output stream of the terminal
+         * \param frame Minimal interval between frames
+         * \param width Number of cells in each bar
+        */
+        explicit progress (std::ostream& os = std::cout, std::chrono::milliseconds frame = std::chrono::milliseconds{ 50 }, unsigned width = 40)
+            : _os{ os }
+            , _frame{ frame }
+            , _width{ width }
+        {}
+
+        /// The renderer thread refers to the object
+        progress (progress const&) = delete;
+        auto operator = (progress const&) -> progress& = delete;
+
+        /**
+         * \brief Destructor. Stops the renderer after the final frame
+        */
+        ~progress ()
+        {
+            stop();
+        }
+
+        /**
+         * \brief Adds a new bar below the existing ones
+         *
+         * \param label Text before the bar
+         * \param total Number of work items
+         * \param clr Color of the filled cells
+         *
+         * \return Reference to the bar (stays valid until the renderer is destroyed)
+        */
+        auto add (std::string label, uint64_t total, face clr = face::green) -> bar&
+        {
+            std::lock_guard lock{ _mutex };
+            return *_bars.emplace_back(std::make_unique<bar>(std::move(label), total, clr));
+        }
+
+        /**
+         * \brief Launches the renderer thread
+        */
+        void start ()
+        {
+            if (_renderer.joinable()) return;
+
+            _stopping = false;
+            _renderer = std::thread{ [this] { _run(); } };
+        }
+
+        /**
+         * \brief Draws the final frame and joins the renderer thread
+        */
+        void stop ()
+        {
+            if (!_renderer.joinable()) return;
+            {
+                std::lock_guard lock{ _mutex };
+                _stopping = true;
+            }
+            _wakeup.notify_one();
+            _renderer.join();
+        }
+
+        /**
+         * \brief Draws a frame immediately (for the use without the renderer thread)
+        */
+        void render ()
+        {
+            std::lock_guard lock{ _mutex };
+            _render_frame();
+        }
+
+    private:
+
+        void _run ()
+        {
+            std::unique_lock lock{ _mutex };
+
+            while (!_wakeup.wait_for(lock, _frame, [this] { return _stopping; }))
+            {
+                _render_frame();
+            }
+            _render_frame();
+        }
+
+        void _render_frame ()
+        {
+            _frame_buffer.clear();
+
+            std::size_t label_width = 0;
+            for (auto& b : _bars) label_width = std::max(label_width, b->_label.size());
+
+            // New width of the labels column shifts everything: draw all the lines anew
+            auto full = label_width != _label_width;
+            _label_width = label_width;
+
+            auto cursor = _shown_bars;          // The cursor is below the last shown line
+
+            for (std::size_t i = 0; i < _bars.size(); ++i)
+            {
+                auto& b = *_bars[i];
+                auto done = b.done(), total = b.total();
+
+                if (!full && i < _shown_bars && done == b._shown_done && total == b._shown_total) continue;
+
+                auto ratio = total ? (double)std::min(done, total) / (double)total : 0.0;
+                auto cells = (unsigned)(ratio * _width);
+                auto percent = (int)(ratio * 100);
+
+                // New lines start below the shown ones, where the cursor is after the previous new line
+                _move_lines((long)i - (long)cursor);
+                cursor = i;
+
+                if (full || i >= _shown_bars || cells < b._shown_cells)
+                {
+                    _frame_buffer += '\r';
+                    _draw_line(b, cells, percent, done, total);
+
+                    if (i >= _shown_bars)
+                    {
+                        _frame_buffer += '\n';
+                        cursor = i + 1;
+                    }
+                }
+                else
+                {
+                    // Appending only the newly filled cells and the numbers after the bar
+                    if (cells > b._shown_cells)
+                    {
+                        _column(_label_width + 2 + b._shown_cells);
+                        _fill(b._color, cells - b._shown_cells);
+                    }
+                    if (percent != b._shown_percent || done != b._shown_done || total != b._shown_total)
+                    {
+                        _column(_label_width + 4 + _width);
+                        _numbers(percent, done, total);
+                    }
+                }
+
+                b._shown_cells = cells;
+                b._shown_percent = percent;
+                b._shown_done = done;
+                b._shown_total = total;
+            }
+
+            _shown_bars = _bars.size();
+            _move_lines((long)_shown_bars - (long)cursor);
+            _set_pen(face::none);
+
+            if (!_frame_buffer.empty())
+            {
+                if (_frame_buffer.back() != '\n') _frame_buffer += '\r';
+                _os.write(_frame_buffer.data(), (std::streamsize)_frame_buffer.size()).flush();
+            }
+        }
+
+        void _draw_line (bar& b, unsigned cells, int percent, uint64_t done, uint64_t total)
+        {
+            _set_pen(face::none);
+            _frame_buffer += b._label;
+            _frame_buffer.append(_label_width - b._label.size() + 1, ' ');
+            _frame_buffer += '[';
+
+            _fill(b._color, cells);
+            _set_pen(bright(face::black));
+
+            for (auto i = cells; i < _width; ++i) _frame_buffer += "░";
+
+            _set_pen(face::none);
+            _frame_buffer += "] ";
+            _numbers(percent, done, total);
+        }
+
+        void _fill (face clr, unsigned count)
+        {
+            _set_pen(clr);
+            while (count--) _frame_buffer += "█";
+        }
+
+        void _numbers (int percent, uint64_t done, uint64_t total)
+        {
+            char text[64];
+            auto* end = text + sizeof text;
+
+            auto* p = std::to_chars(text, end, percent).ptr;
+            *p++ = '%';
+            *p++ = ' ';
+            p = std::to_chars(p, end, done).ptr;
+            *p++ = '/';
+            p = std::to_chars(p, end, total).ptr;
+
+            _set_pen(face::none);
+            _frame_buffer.append(text, p);
+            _frame_buffer += "\033[K";
+        }
+
+        void _set_pen (face clr)
+        {
+            if (!enabled || clr == _pen) return;
+
+            _pen = clr;
+            _frame_buffer += clr == face::none ? std::string_view{ "\033[39m" } : to_escape(clr, back::none).view();
+        }
+
+        void _move_lines (long delta)
+        {
+            if (!delta) return;
+
+            char text[16];
+            auto* p = std::to_chars(text, text + sizeof text, delta < 0 ? -delta : delta).ptr;
+
+            _frame_buffer += "\033[";
+            _frame_buffer.append(text, p);
+            _frame_buffer += delta < 0 ? 'A' : 'B';
+        }
+
+        void _column (std::size_t col)
+        {
+            char text[16];
+            auto* p = std::to_chars(text, text + sizeof text, col + 1).ptr;
+
+            _frame_buffer += "\033[";
+            _frame_buffer.append(text, p);
+            _frame_buffer += 'G';
+        }
+    };
+
+}   // end namespace tesc
+
+#endif  // TESC_PROGRESS_H
+
+// MIT License
+//
+// Copyright (c) 2020-2021 Alex Qzminsky
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
@@ -0,0 +1,350 @@
+#pragma once
+
+// Copyright © 2020-2021 Alex Qzminsky.
+// License: MIT. All rights reserved.
+
+/// \brief Recording of the output stream into an asciicast v2 file
+///
+/// \author https://github.com/qzminsky
+
+#ifndef TESC_RECORD_H
+#define TESC_RECORD_H
+
+#include "../tesc.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tesc
+{
+    /**
+     * \class recorder
+     *
+     * \brief Tees everything written to an output stream into an asciicast v2 file
+     *
+     * \details Substitutes the stream buffer with a buffered pass-through one which also keeps
+     * the written bytes. Each flush of the stream (i.e. the moment the output becomes visible)
+     * turns them into a single event stamped by the monotonic clock. Events are handed to a
+     * background thread in batches, which formats them and writes the file, so the interactive
+     * path only copies bytes and takes an uncontended lock per flush
+     *
+     * \note The written bytes reach the original stream buffer by blocks and on flushes
+    */
+    class recorder
+    {
+        using clock = std::chrono::steady_clock;
+
+        /// Output events: times and the ends of their data in the shared text
+        struct _batch
+        {
+            std::string data;
+            std::vector<std::pair<clock::duration, std::size_t>> marks;
+        };
+
+        class _buffer : public std::streambuf
+        {
+        public:
+
+            std::streambuf* _target;
+            recorder* _owner;
+            std::string _pending;               ///< Written bytes since the last event
+
+            _buffer (std::streambuf* target, recorder* owner) : _target{ target }, _owner{ owner }
+            {
+                setp(_area, _area + sizeof _area);
+            }
+
+            /**
+             * \brief Passes the buffered bytes to the target and keeps them for the event
+            */
+            auto drain () -> bool
+            {
+                auto n = pptr() - pbase();
+                if (!n) return true;
+
+                auto res = _target->sputn(pbase(), n);
+                if (res > 0) _pending.append(pbase(), (std::size_t)res);
+
+                setp(_area, _area + sizeof _area);
+                return res == n;
+            }
+
+        protected:
+
+            auto overflow (int_type ch) -> int_type override
+            {
+                if (!drain()) return traits_type::eof();
+                if (traits_type::eq_int_type(ch, traits_type::eof())) return traits_type::not_eof(ch);
+
+                *pptr() = traits_type::to_char_type(ch);
+                pbump(1);
+
+                if (_pending.size() >= _max_pending) _owner->_submit(_pending);
+                return ch;
+            }
+
+            auto sync () -> int override
+            {
+                auto drained = drain();
+                auto res = _target->pubsync();
+
+                if (!_pending.empty()) _owner->_submit(_pending);
+                return drained ? res : -1;
+            }
+
+        private:
+
+            /// Events are made without a flush too, if the application doesn't flush for long
+            static constexpr std::size_t _max_pending = 1 << 16;
+
+            /// Writes are collected here, so the stream doesn't call virtual functions for them
+            char _area[4096];
+        };
+
+        std::ostream& _os;
+        std::ofstream _file;
+        clock::time_point _origin;
+        _buffer _buf;
+
+        std::mutex _mutex;
+        std::condition_variable _wakeup;
+        _batch _shared;                         ///< Events not taken by the writer yet
+        bool _stopping = false;
+
+        std::thread _writer;
+
+    public:
+
+        /**
+         * \brief Starts recording of the output stream
+         *
+         * \param os Output stream
+         * \param path Path of the asciicast file
+         * \param width, height Terminal size written to the file header
+         *
+         * \throw std::runtime_error if the file cannot be opened
+        */
+        recorder (std::ostream& os, std::string const& path, unsigned width = 80, unsigned height = 24)
+            : _os{ os }
+            , _file{ path, std::ios::binary | std::ios::trunc }
+            , _origin{ clock::now() }
+            , _buf{ os.rdbuf(), this }
+        {
+            if (!_file) throw std::runtime_error{ "tesc::recorder: cannot open '" + path + "'" };
+
+            _file << "{\"version\": 2, \"width\": " << width << ", \"height\": " << height
+                  << ", \"timestamp\": " << (long long)std::time(nullptr) << "}\n";
+
+            _writer = std::thread{ [this] { _run(); } };
+
+            _os.flush();
+            _os.rdbuf(&_buf);
+        }
+
+        /// Restoring of the stream buffer can happen only once
+        recorder (recorder const&) = delete;
+        auto operator = (recorder const&) -> recorder& = delete;
+
+        /**
+         * \brief Destructor. Restores the original stream buffer and completes the file
+        */
+        ~recorder ()
+        {
+            _os.flush();
+            _os.rdbuf(_buf._target);
+
+            {
+                std::lock_guard lock{ _mutex };
+                _stopping = true;
+            }
+            _wakeup.notify_one();
+            _writer.join();
+        }
+
+    private:
+
+        /// Interval between the writes of batches
+        static constexpr auto _period = std::chrono::milliseconds{ 100 };
+
+        /**
+         * \brief Turns pending bytes into an event
+        */
+        void _submit (std::string& pending)
+        {
+            auto now = clock::now() - _origin;
+
+            // A multibyte character can't be split between events
+            auto keep = _incomplete_tail(pending);
+            {
+                std::lock_guard lock{ _mutex };
+
+                _shared.data.append(pending, 0, pending.size() - keep);
+                _shared.marks.emplace_back(now, _shared.data.size());
+            }
+            pending.erase(0, pending.size() - keep);
+        }
+
+        /**
+         * \brief Returns the number of trailing bytes of an incomplete UTF-8 character
+        */
+        static auto _incomplete_tail (std::string const& text) -> std::size_t
+        {
+            for (std::size_t back = 1; back <= 4 && back <= text.size(); ++back)
+            {
+                auto ch = (uint8_t)text[text.size() - back];
+
+                if ((ch & 0xC0) == 0x80) continue;  // A continuation byte
+                if (ch < 0x80) return 0;
+
+                auto length = ch >= 0xF0 ? 4u : ch >= 0xE0 ? 3u : 2u;
+                return back < length ? back : 0;
+            }
+            return 0;
+        }
+
+        void _run ()
+        {
+            _batch local;
+            std::string line;
+
+            for (auto stopping = false; !stopping;)
+            {
+                {
+                    std::unique_lock lock{ _mutex };
+                    _wakeup.wait_for(lock, _period, [this] { return _stopping; });
+
+                    std::swap(local, _shared);
+                    stopping = _stopping;
+                }
+
+                std::size_t begin = 0;
+                for (auto [time, end] : local.marks)
+                {
+                    if (begin == end) continue;
+
+                    _format(line, time, { local.data.data() + begin, end - begin });
+                    begin = end;
+                }
+                _file.write(line.data(), (std::streamsize)line.size()).flush();
+
+                line.clear();
+                local.data.clear();
+                local.marks.clear();
+            }
+        }
+
+        /**
+         * \brief Appends an event as a JSON line `[time, "o", data]`
+        */
+        static void _format (std::string& out, clock::duration time, std::string_view data)
+        {
+            char head[48];
+            auto us = std::chrono::duration_cast<std::chrono::microseconds>(time).count();
+
+            std::snprintf(head, sizeof head, "[%lld.%06lld, \"o\", \"", (long long)(us / 1000000), (long long)(us % 1000000));
+            out += head;
+
+            for (std::size_t i = 0, run = 0; i <= data.size(); ++i)
+            {
+                auto ch = i < data.size() ? (uint8_t)data[i] : 0;
+
+                if (i < data.size() && ch >= 0x20 && ch != '"' && ch != '\\' && ch != 0x7F)
+                {
+                    if (ch < 0x80) continue;
+
+                    // Valid characters go as they are; the other bytes are replaced
+                    if (auto length = _utf8_length(data, i))
+                    {
+                        i += length - 1;
+                        continue;
+                    }
+                }
+
+                // Bytes which don't need escaping go as a whole
+                out.append(data.data() + run, i - run);
+                run = i + 1;
+
+                if (i == data.size()) break;
+
+                switch (ch)
+                {
+                case '"':  out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+
+                default:
+                    if (ch >= 0x80)
+                    {
+                        out += "\\ufffd";
+                        break;
+                    }
+                    char code[8];
+                    std::snprintf(code, sizeof code, "\\u%04x", (unsigned)ch);
+                    out += code;
+                }
+            }
+            out += "\"]\n";
+        }
+
+        /**
+         * \brief Returns the length of a valid UTF-8 character at the position, or 0
+         *
+         * \details Overlong forms, surrogates and code points above U+10FFFF are not valid
+        */
+        static auto _utf8_length (std::string_view data, std::size_t pos) -> std::size_t
+        {
+            auto lead = (uint8_t)data[pos];
+            auto length = lead >= 0xC2 && lead <= 0xDF ? 2u : lead >= 0xE0 && lead <= 0xEF ? 3u : lead >= 0xF0 && lead <= 0xF4 ? 4u : 0u;
+
+            if (!length || data.size() - pos < length) return 0;
+
+            // The range of the second byte depends on the lead one
+            auto lo = lead == 0xE0 ? 0xA0 : lead == 0xF0 ? 0x90 : 0x80;
+            auto hi = lead == 0xED ? 0x9F : lead == 0xF4 ? 0x8F : 0xBF;
+
+            auto second = (uint8_t)data[pos + 1];
+            if (second < lo || second > hi) return 0;
+
+            for (std::size_t k = 2; k < length; ++k)
+            {
+                if (((uint8_t)data[pos + k] & 0xC0) != 0x80) return 0;
+            }
+            return length;
+        }
+    };
+
+}   // end namespace tesc
+
+#endif  // TESC_RECORD_H
+
+// MIT License
+//
+// Copyright (c) 2020-2021 Alex Qzminsky
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
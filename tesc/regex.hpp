@@ -0,0 +1,872 @@
+#pragma once
+
+// Copyright © 2020-2021 Alex Qzminsky.
+// License: MIT. All rights reserved.
+
+/// \brief Table-driven DFA for a small regular expressions subset
+///
+/// \author https://github.com/qzminsky
+
+#ifndef TESC_REGEX_H
+#define TESC_REGEX_H
+
+#include <algorithm>
+#include <bitset>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace tesc
+{
+    /**
+     * \internal
+     * \class _nfa
+     *
+     * \brief Thompson automaton with byte sets, epsilons and line anchors on its edges
+    */
+    class _nfa
+    {
+    public:
+
+        using charset = std::bitset<256>;
+
+        /// Kinds of edges: `bol` and `eol` pass only at the beginning and at the end of the text
+        enum kind : uint8_t { eps, consume, bol, eol };
+
+        struct edge
+        {
+            charset set;
+            int32_t target;
+            kind type;
+        };
+
+        /// Sub-automaton with a single entry and a single exit
+        struct fragment
+        {
+            int32_t start, accept;
+        };
+
+        std::vector<std::vector<edge>> nodes;
+        std::vector<int32_t> rule;              ///< Expression accepted in the node (-1 if none)
+
+        auto add () -> int32_t
+        {
+            nodes.emplace_back();
+            rule.push_back(-1);
+
+            return (int32_t)nodes.size() - 1;
+        }
+
+        void link (int32_t from, int32_t to, kind type = eps, charset const& set = {})
+        {
+            nodes[(std::size_t)from].push_back({ set, to, type });
+        }
+
+        /**
+         * \brief Builds the automaton of the reversed language of a fragment
+         *
+         * \param frag Fragment to reverse
+         *
+         * \return Automaton to be started at `frag.accept`, which accepts at `frag.start`
+        */
+        [[nodiscard]]
+        auto reversed (fragment frag) const -> _nfa
+        {
+            _nfa rev;
+            rev.nodes.resize(nodes.size());
+            rev.rule.assign(nodes.size(), -1);
+
+            for (std::size_t from = 0; from < nodes.size(); ++from)
+            {
+                for (auto& e : nodes[from])
+                {
+                    // The anchors swap their sides in the reversed text
+                    auto type = e.type == bol ? eol : e.type == eol ? bol : e.type;
+                    rev.nodes[(std::size_t)e.target].push_back({ e.set, (int32_t)from, type });
+                }
+            }
+            rev.rule[(std::size_t)frag.start] = 0;
+
+            return rev;
+        }
+    };
+
+    /**
+     * \internal
+     * \class _regex_parser
+     *
+     * \brief Recursive descent parser adding an expression to the NFA
+    */
+    class _regex_parser
+    {
+        using charset = _nfa::charset;
+        using fragment = _nfa::fragment;
+
+        static constexpr int _max_repeat = 1000;
+
+        std::string_view _src;
+        std::size_t _pos = 0;
+        _nfa& _nfa_ref;
+
+    public:
+
+        _regex_parser (std::string_view src, _nfa& nfa) : _src{ src }, _nfa_ref{ nfa } {}
+
+        auto parse () -> fragment
+        {
+            auto frag = _alternation();
+            if (_pos != _src.size()) _fail("unmatched ')'");
+
+            return frag;
+        }
+
+    private:
+
+        [[noreturn]] void _fail (char const* what) const
+        {
+            throw std::invalid_argument{
+                std::string{ "tesc::regex: " } + what + " at " + std::to_string(_pos) + " in '" + std::string{ _src } + "'"
+            };
+        }
+
+        auto _peek (char ch) const -> bool
+        {
+            return _pos < _src.size() && _src[_pos] == ch;
+        }
+
+        auto _empty () -> fragment
+        {
+            auto n = _nfa_ref.add();
+            return { n, n };
+        }
+
+        auto _alternation () -> fragment
+        {
+            auto frag = _sequence();
+            if (!_peek('|')) return frag;
+
+            fragment alt{ _nfa_ref.add(), _nfa_ref.add() };
+
+            for (;;)
+            {
+                _nfa_ref.link(alt.start, frag.start);
+                _nfa_ref.link(frag.accept, alt.accept);
+
+                if (!_peek('|')) return alt;
+
+                ++_pos;
+                frag = _sequence();
+            }
+        }
+
+        auto _sequence () -> fragment
+        {
+            auto frag = _empty();
+
+            while (_pos < _src.size() && !_peek('|') && !_peek(')'))
+            {
+                auto next = _quantified();
+
+                _nfa_ref.link(frag.accept, next.start);
+                frag.accept = next.accept;
+            }
+            return frag;
+        }
+
+        auto _quantified () -> fragment
+        {
+            auto atom_pos = _pos;
+            auto frag = _atom();
+
+            if (_pos == _src.size()) return frag;
+
+            switch (_src[_pos])
+            {
+            case '*': ++_pos; return _star(frag);
+            case '+': ++_pos; return _plus(frag);
+            case '?': ++_pos; return _optional(frag);
+            case '{': return _counted(frag, atom_pos);
+
+            default:
+                return frag;
+            }
+        }
+
+        auto _star (fragment frag) -> fragment
+        {
+            fragment loop{ _nfa_ref.add(), _nfa_ref.add() };
+
+            _nfa_ref.link(loop.start, frag.start);
+            _nfa_ref.link(loop.start, loop.accept);
+            _nfa_ref.link(frag.accept, frag.start);
+            _nfa_ref.link(frag.accept, loop.accept);
+
+            return loop;
+        }
+
+        auto _plus (fragment frag) -> fragment
+        {
+            auto accept = _nfa_ref.add();
+
+            _nfa_ref.link(frag.accept, frag.start);
+            _nfa_ref.link(frag.accept, accept);
+
+            return { frag.start, accept };
+        }
+
+        auto _optional (fragment frag) -> fragment
+        {
+            fragment opt{ _nfa_ref.add(), _nfa_ref.add() };
+
+            _nfa_ref.link(opt.start, frag.start);
+            _nfa_ref.link(opt.start, opt.accept);
+            _nfa_ref.link(frag.accept, opt.accept);
+
+            return opt;
+        }
+
+        /**
+         * \brief Parses `{m}`, `{m,}` or `{m,n}` after an atom
+         *
+         * \details Every copy of the atom needs its own nodes, so the atom is parsed again
+         * from its source position for each of them
+        */
+        auto _counted (fragment first, std::size_t atom_pos) -> fragment
+        {
+            auto number = [this] () -> int
+            {
+                auto value = -1;
+                while (_pos < _src.size() && std::isdigit((uint8_t)_src[_pos]))
+                {
+                    value = (value < 0 ? 0 : value * 10) + (_src[_pos++] - '0');
+                    if (value > _max_repeat) _fail("too large repetition");
+                }
+                return value;
+            };
+
+            ++_pos;
+            auto min = number(), max = min;
+
+            if (min < 0) _fail("expected a number");
+            if (_peek(','))
+            {
+                ++_pos;
+                max = number();
+            }
+            if (!_peek('}')) _fail("expected '}'");
+            if (max >= 0 && max < min) _fail("invalid repetition range");
+
+            auto end_pos = ++_pos;
+            auto copies = 0;
+
+            auto next_copy = [&] () -> fragment
+            {
+                if (!copies++) return first;
+
+                _pos = atom_pos;
+                auto frag = _atom();
+                _pos = end_pos;
+
+                return frag;
+            };
+
+            auto result = _empty();
+            auto append = [&] (fragment frag)
+            {
+                _nfa_ref.link(result.accept, frag.start);
+                result.accept = frag.accept;
+            };
+
+            for (auto i = 0; i < min; ++i) append(next_copy());
+
+            if (max < 0) append(_star(next_copy()));
+            else
+            {
+                for (auto i = min; i < max; ++i) append(_optional(next_copy()));
+            }
+            return result;
+        }
+
+        auto _atom () -> fragment
+        {
+            charset set;
+
+            switch (auto ch = _src[_pos++])
+            {
+            case '(': {
+                auto frag = _alternation();
+                if (!_peek(')')) _fail("expected ')'");
+
+                ++_pos;
+                return frag;
+            }
+            case '^':
+            case '$': {
+                fragment frag{ _nfa_ref.add(), _nfa_ref.add() };
+                _nfa_ref.link(frag.start, frag.accept, ch == '^' ? _nfa::bol : _nfa::eol);
+
+                return frag;
+            }
+            case '.':
+                set.set().reset('\n');
+                break;
+
+            case '[':
+                set = _class();
+                break;
+
+            case '\\':
+                set = _escape();
+                break;
+
+            case '*': case '+': case '?': case '{':
+                --_pos, _fail("nothing to repeat");
+
+            case '}':
+                --_pos, _fail("unmatched '}'");
+
+            default:
+                set.set((uint8_t)ch);
+            }
+
+            fragment frag{ _nfa_ref.add(), _nfa_ref.add() };
+            _nfa_ref.link(frag.start, frag.accept, _nfa::consume, set);
+
+            return frag;
+        }
+
+        auto _escape () -> charset
+        {
+            if (_pos == _src.size()) _fail("trailing backslash");
+
+            charset set;
+
+            switch (auto ch = _src[_pos++])
+            {
+            case 'd': case 'D':
+                for (auto c = '0'; c <= '9'; ++c) set.set((uint8_t)c);
+                return ch == 'd' ? set : ~set;
+
+            case 'w': case 'W':
+                for (auto c = 0; c < 256; ++c) set[(std::size_t)c] = std::isalnum(c) || c == '_';
+                return ch == 'w' ? set : ~set;
+
+            case 's': case 'S':
+                for (auto c : { ' ', '\t', '\n', '\r', '\f', '\v' }) set.set((uint8_t)c);
+                return ch == 's' ? set : ~set;
+
+            case 't': return set.set('\t');
+            case 'n': return set.set('\n');
+            case 'r': return set.set('\r');
+
+            default:
+                return set.set((uint8_t)ch);
+            }
+        }
+
+        auto _class () -> charset
+        {
+            charset set;
+            auto negate = _peek('^');
+            if (negate) ++_pos;
+
+            for (auto first = true; ; first = false)
+            {
+                if (_pos == _src.size()) _fail("unterminated class");
+                if (_src[_pos] == ']' && !first) break;
+
+                if (_src[_pos] == '\\')
+                {
+                    ++_pos;
+                    set |= _escape();
+                    continue;
+                }
+
+                auto lo = (uint8_t)_src[_pos++];
+
+                if (_pos + 1 < _src.size() && _src[_pos] == '-' && _src[_pos + 1] != ']')
+                {
+                    auto hi = (uint8_t)_src[_pos + 1];
+                    if (hi < lo) _fail("invalid range");
+
+                    for (auto c = lo; ; ++c) { set.set(c); if (c == hi) break; }
+                    _pos += 2;
+                }
+                else set.set(lo);
+            }
+            ++_pos;
+
+            return negate ? ~set : set;
+        }
+    };
+
+    /**
+     * \internal
+     * \class _dfa
+     *
+     * \brief Deterministic automaton over byte equivalence classes
+     *
+     * \details State 0 is dead. The automaton starts in `start[1]` at the beginning of the text
+     * and in `start[0]` elsewhere. The last column stands for the end of the text: it leads to
+     * the states reached by passing `$` anchors
+    */
+    class _dfa
+    {
+        static constexpr std::size_t _max_states = 8192;
+
+    public:
+
+        uint8_t classes[256] = {};              ///< Byte → equivalence class
+        std::size_t columns = 0;                ///< Number of classes plus the end column
+        std::vector<int32_t> table;             ///< Transitions: state * columns + class
+        std::vector<uint32_t> accept_offset;    ///< Accepted expressions of the state `s`:
+        std::vector<uint16_t> accept_rules;     ///< `accept_rules[accept_offset[s]...accept_offset[s + 1]]`
+        int32_t start[2] = {};
+
+        /**
+         * \brief Builds the automaton by the subset construction
+         *
+         * \param nfa Source automaton
+         * \param entries Start nodes
+         * \param unanchored Whether matches may start at any position (or only at the start one)
+         *
+         * \throw std::invalid_argument if there are too many states
+        */
+        void build (_nfa const& nfa, std::vector<int32_t> const& entries, bool unanchored)
+        {
+            _split_classes(nfa);
+
+            std::map<std::vector<int32_t>, int32_t> ids;
+            std::vector<std::vector<int32_t>> sets;
+
+            auto intern = [&] (std::vector<int32_t> set) -> int32_t
+            {
+                if (set.empty()) return 0;
+
+                auto [it, inserted] = ids.try_emplace(set, (int32_t)sets.size() + 1);
+                if (inserted)
+                {
+                    if (sets.size() == _max_states) throw std::invalid_argument{ "tesc::regex: expressions are too complex" };
+
+                    auto first = accept_rules.size();
+                    for (auto n : set)
+                    {
+                        if (auto r = nfa.rule[(std::size_t)n]; r >= 0) accept_rules.push_back((uint16_t)r);
+                    }
+                    std::sort(accept_rules.begin() + (std::ptrdiff_t)first, accept_rules.end());
+                    accept_rules.erase(std::unique(accept_rules.begin() + (std::ptrdiff_t)first, accept_rules.end()), accept_rules.end());
+                    accept_offset.push_back((uint32_t)accept_rules.size());
+
+                    sets.push_back(std::move(set));
+                    table.resize(table.size() + columns, 0);
+                }
+                return it->second;
+            };
+
+            // The dead state
+            table.assign(columns, 0);
+            accept_offset.assign(2, 0);
+            accept_rules.clear();
+
+            auto restart = _closure(nfa, entries, false, false);
+
+            start[1] = intern(_closure(nfa, entries, true, false));
+            start[0] = intern(restart);
+
+            // A representative byte of each class
+            std::vector<std::size_t> bytes(columns - 1);
+            for (auto b = 256; b--;) bytes[classes[b]] = (std::size_t)b;
+
+            for (std::size_t d = 0; d < sets.size(); ++d)
+            {
+                for (std::size_t cls = 0; cls + 1 < columns; ++cls)
+                {
+                    std::vector<int32_t> next;
+
+                    for (auto n : sets[d])
+                    {
+                        for (auto& e : nfa.nodes[(std::size_t)n])
+                        {
+                            if (e.type == _nfa::consume && e.set[bytes[cls]]) next.push_back(e.target);
+                        }
+                    }
+                    if (unanchored) next.insert(next.end(), restart.begin(), restart.end());
+
+                    auto target = intern(_closure(nfa, next, false, false));
+                    table[(d + 1) * columns + cls] = target;
+                }
+
+                // Passing the `$` anchors; only the accepting results are of interest
+                auto final_set = _closure(nfa, sets[d], false, true);
+                auto accepts = std::any_of(final_set.begin(), final_set.end(), [&] (int32_t n) { return nfa.rule[(std::size_t)n] >= 0; });
+
+                if (accepts)
+                {
+                    auto target = intern(std::move(final_set));
+                    table[(d + 1) * columns + columns - 1] = target;
+                }
+            }
+        }
+
+        /**
+         * \brief Returns the transition by a byte
+        */
+        [[nodiscard]]
+        auto step (int32_t state, char ch) const -> int32_t
+        {
+            return table[(std::size_t)state * columns + classes[(uint8_t)ch]];
+        }
+
+        /**
+         * \brief Returns the transition by the end of the text
+        */
+        [[nodiscard]]
+        auto finish (int32_t state) const -> int32_t
+        {
+            return table[(std::size_t)state * columns + columns - 1];
+        }
+
+        /**
+         * \brief Predicate. Checks if the state accepts any expression
+        */
+        [[nodiscard]]
+        auto accepting (int32_t state) const -> bool
+        {
+            return accept_offset[(std::size_t)state] != accept_offset[(std::size_t)state + 1];
+        }
+
+        /**
+         * \brief Returns the length of the longest match starting at the position
+         *
+         * \return Length or `npos` of `std::string_view` if there is no match
+        */
+        [[nodiscard]]
+        auto longest (std::string_view text, std::size_t pos) const -> std::size_t
+        {
+            auto state = start[pos == 0];
+            auto best = accepting(state) ? 0 : std::string_view::npos;
+            auto i = pos;
+
+            for (; i < text.size() && state; ++i)
+            {
+                state = step(state, text[i]);
+                if (accepting(state)) best = i + 1 - pos;
+            }
+            if (state && finish(state)) best = i - pos;
+
+            return best;
+        }
+
+    private:
+
+        /**
+         * \brief Splits bytes into classes which no edge of the NFA can tell apart
+        */
+        void _split_classes (_nfa const& nfa)
+        {
+            std::vector<_nfa::charset const*> sets;
+            for (auto& node : nfa.nodes)
+            {
+                for (auto& e : node) if (e.type == _nfa::consume) sets.push_back(&e.set);
+            }
+
+            std::map<std::vector<bool>, uint8_t> signatures;
+
+            for (auto b = 0; b < 256; ++b)
+            {
+                std::vector<bool> signature(sets.size());
+                for (std::size_t i = 0; i < sets.size(); ++i) signature[i] = (*sets[i])[(std::size_t)b];
+
+                auto [it, inserted] = signatures.try_emplace(std::move(signature), (uint8_t)signatures.size());
+                classes[b] = it->second;
+            }
+            columns = signatures.size() + 1;
+        }
+
+        static auto _closure (_nfa const& nfa, std::vector<int32_t> const& from, bool at_begin, bool at_end) -> std::vector<int32_t>
+        {
+            std::vector<bool> seen(nfa.nodes.size());
+            std::vector<int32_t> stack{ from }, result;
+
+            while (!stack.empty())
+            {
+                auto n = stack.back();
+                stack.pop_back();
+
+                if (seen[(std::size_t)n]) continue;
+
+                seen[(std::size_t)n] = true;
+                result.push_back(n);
+
+                for (auto& e : nfa.nodes[(std::size_t)n])
+                {
+                    if (e.type == _nfa::eps || (e.type == _nfa::bol && at_begin) || (e.type == _nfa::eol && at_end))
+                    {
+                        stack.push_back(e.target);
+                    }
+                }
+            }
+            std::sort(result.begin(), result.end());
+
+            return result;
+        }
+    };
+
+    /**
+     * \class regex
+     *
+     * \brief Regular expression compiled into a deterministic automaton
+     *
+     * \details Supported syntax: literal characters, `.`, classes (`[a-z_]`, `[^0-9]`),
+     * escapes (`\d`, `\w`, `\s`, their negations and escaped metacharacters), groups `(...)`,
+     * alternation `|`, the `*`, `+`, `?`, `{m}`, `{m,}`, `{m,n}` quantifiers and the `^`, `$`
+     * anchors (the text is a single line). Matching costs a single table lookup per input byte
+    */
+    class regex
+    {
+        _dfa _automaton;
+
+    public:
+
+        /**
+         * \brief Compiles the expression
+         *
+         * \param pattern Expression source
+         *
+         * \throw std::invalid_argument if the expression is malformed or too complex
+        */
+        explicit regex (std::string_view pattern)
+        {
+            _nfa nfa;
+            auto frag = _regex_parser{ pattern, nfa }.parse();
+
+            nfa.rule[(std::size_t)frag.accept] = 0;
+            _automaton.build(nfa, { frag.start }, false);
+        }
+
+        /**
+         * \brief Returns the length of the longest match starting at the given position
+         *
+         * \param text Input text
+         * \param pos Start position
+         *
+         * \return Length or `npos` if there is no match
+        */
+        [[nodiscard]]
+        auto match_at (std::string_view text, std::size_t pos) const -> std::size_t
+        {
+            return _automaton.longest(text, pos);
+        }
+
+        /**
+         * \brief Reports leftmost-longest non-overlapping non-empty matches
+         *
+         * \param text Input text
+         * \param on_match Callback `(std::size_t begin, std::size_t end)`
+        */
+        template <typename Callback>
+        void scan (std::string_view text, Callback&& on_match) const
+        {
+            for (std::size_t pos = 0; pos < text.size();)
+            {
+                auto len = match_at(text, pos);
+
+                if (len != npos && len)
+                {
+                    on_match(pos, pos + len);
+                    pos += len;
+                }
+                else ++pos;
+            }
+        }
+
+        static constexpr std::size_t npos = std::string_view::npos;
+    };
+
+    /**
+     * \class regex_set
+     *
+     * \brief Set of regular expressions matched simultaneously in a single pass
+     *
+     * \details All the expressions are compiled into one unanchored automaton which finds,
+     * in a single pass, which of them match and where their last matches end. For each matching
+     * expression an unanchored run of its reversed automaton from that end marks the positions
+     * where its non-empty matches start, and its own automaton takes the longest match at the
+     * leftmost of them. So the matches are the same as the ones of `regex::scan`: leftmost-longest,
+     * non-overlapping, reported from left to right for each expression in turn
+     *
+     * \note The passes besides the first one are made only over the lines an expression matches
+    */
+    class regex_set
+    {
+        _nfa _combined;
+        std::vector<_nfa::fragment> _rules;
+        _dfa _forward;
+        std::vector<_dfa> _anchored;
+        std::vector<_dfa> _backward;
+        bool _built = false;
+
+    public:
+
+        /**
+         * \brief Adds an expression. Invalidates the automata until the next `build()`
+         *
+         * \param pattern Expression source (see `regex` for the syntax)
+         *
+         * \return Expression identifier (sequential, starting from zero)
+         *
+         * \throw std::invalid_argument if the expression is malformed
+        */
+        auto add (std::string_view pattern) -> std::size_t
+        {
+            auto frag = _regex_parser{ pattern, _combined }.parse();
+
+            _combined.rule[(std::size_t)frag.accept] = (int32_t)_rules.size();
+            _rules.push_back(frag);
+            _built = false;
+
+            return _rules.size() - 1;
+        }
+
+        /**
+         * \brief Returns the number of expressions
+        */
+        [[nodiscard]]
+        auto size () const -> std::size_t
+        {
+            return _rules.size();
+        }
+
+        /**
+         * \brief Compiles the automata
+         *
+         * \throw std::invalid_argument if the expressions are too complex
+        */
+        void build ()
+        {
+            std::vector<int32_t> entries;
+            for (auto& r : _rules) entries.push_back(r.start);
+
+            _forward.build(_combined, entries, true);
+            _anchored.resize(_rules.size());
+            _backward.resize(_rules.size());
+
+            for (std::size_t i = 0; i < _rules.size(); ++i)
+            {
+                _anchored[i].build(_combined, { _rules[i].start }, false);
+                _backward[i].build(_combined.reversed(_rules[i]), { _rules[i].accept }, true);
+            }
+            _built = true;
+        }
+
+        /**
+         * \brief Reports non-empty matches of all the expressions
+         *
+         * \param text Input text
+         * \param on_match Callback `(std::size_t id, std::size_t begin, std::size_t end)`
+         *
+         * \note Requires `build()` after the last `add()`
+        */
+        template <typename Callback>
+        void scan (std::string_view text, Callback&& on_match) const
+        {
+            if (!_built || _rules.empty()) return;
+
+            // End of the last match of each expression (0 if none); reused between the calls
+            thread_local std::vector<std::size_t> last_end;
+            last_end.assign(_rules.size(), 0);
+
+            auto collect = [&] (int32_t state, std::size_t pos)
+            {
+                for (auto k = _forward.accept_offset[(std::size_t)state]; k < _forward.accept_offset[(std::size_t)state + 1]; ++k)
+                {
+                    last_end[_forward.accept_rules[k]] = pos;
+                }
+            };
+
+            auto state = _forward.start[1];
+
+            for (std::size_t i = 0; i < text.size(); ++i)
+            {
+                state = _forward.step(state, text[i]);
+                if (_forward.accepting(state)) collect(state, i + 1);
+            }
+            if (auto last = _forward.finish(state)) collect(last, text.size());
+
+            for (std::size_t rule = 0; rule < _rules.size(); ++rule)
+            {
+                if (last_end[rule]) _scan_rule(rule, text, last_end[rule], on_match);
+            }
+        }
+
+    private:
+
+        /**
+         * \brief Reports leftmost-longest matches of a single expression
+         *
+         * \param limit End of the last match of the expression
+        */
+        template <typename Callback>
+        void _scan_rule (std::size_t rule, std::string_view text, std::size_t limit, Callback& on_match) const
+        {
+            // Whether a non-empty match starts at the position
+            thread_local std::vector<bool> starts;
+            starts.assign(limit, false);
+
+            auto& backward = _backward[rule];
+            auto state = backward.start[limit == text.size()];
+
+            for (auto i = limit; i > 0; --i)
+            {
+                state = backward.step(state, text[i - 1]);
+                starts[i - 1] = backward.accepting(state);
+            }
+            if (backward.finish(state)) starts[0] = true;
+
+            for (std::size_t pos = 0; pos < limit;)
+            {
+                auto len = starts[pos] ? _anchored[rule].longest(text, pos) : 0;
+
+                if (len == std::string_view::npos || !len)
+                {
+                    ++pos;
+                    continue;
+                }
+
+                on_match(rule, pos, pos + len);
+                pos += len;
+            }
+        }
+    };
+
+}   // end namespace tesc
+
+#endif  // TESC_REGEX_H
+
+// MIT License
+//
+// Copyright (c) 2020-2021 Alex Qzminsky
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
@@ -0,0 +1,278 @@
+#pragma once
+
+// Copyright © 2020-2021 Alex Qzminsky.
+// License: MIT. All rights reserved.
+
+/// \brief Rendering of terminal screens into SVG images
+///
+/// \author https://github.com/qzminsky
+
+#ifndef TESC_SVG_H
+#define TESC_SVG_H
+
+#include "vt.hpp"
+
+#include <charconv>
+#include <string>
+#include <string_view>
+
+namespace tesc
+{
+    /**
+     * \struct svg_theme
+     *
+     * \brief Colors and metrics of rendered screens
+    */
+    struct svg_theme
+    {
+        std::string_view background;            ///< Default background color
+        std::string_view foreground;            ///< Default foreground color
+        std::string_view palette[16];           ///< Colors 30...37 (40...47), then the bright ones
+        std::string_view font_family;
+        unsigned font_size;                     ///< In pixels
+        unsigned cell_width, cell_height;       ///< In pixels
+    };
+
+    /// Dark theme with the xterm palette
+    inline constexpr svg_theme xterm_theme = {
+        "#000000", "#e5e5e5",
+        {
+            "#000000", "#cd0000", "#00cd00", "#cdcd00", "#0000ee", "#cd00cd", "#00cdcd", "#e5e5e5",
+            "#7f7f7f", "#ff0000", "#00ff00", "#ffff00", "#5c5cff", "#ff00ff", "#00ffff", "#ffffff",
+        },
+        "Menlo,Consolas,'DejaVu Sans Mono',monospace", 14, 8, 17,
+    };
+
+    /**
+     * \internal
+     * \brief Returns the palette index of a color code (30...37, 90...97 or the background ones), or -1
+    */
+    constexpr auto _palette_index (uint8_t code, uint8_t base) -> int
+    {
+        if (code >= base && code < base + 8) return code - base;
+        if (code >= base + 60 && code < base + 68) return code - base - 52;
+
+        return -1;
+    }
+
+    /**
+     * \brief Appends the screen of the terminal as an SVG image to the buffer
+     *
+     * \details Backgrounds are drawn as rectangles and texts as `<text>` elements, each one
+     * covering a run of adjacent cells of the same style. Colors and font styles are referred
+     * by CSS classes declared once per image, and trailing blanks are not drawn at all
+     *
+     * \param term Terminal with the screen to render
+     * \param out Output buffer
+     * \param theme Colors and metrics
+    */
+    inline void render_svg (terminal const& term, std::string& out, svg_theme const& theme = xterm_theme)
+    {
+        auto number = [&out] (std::size_t value)
+        {
+            char text[24];
+            out.append(text, std::to_chars(text, text + sizeof text, value).ptr);
+        };
+
+        auto const w = theme.cell_width, h = theme.cell_height;
+        auto const baseline = h - (h - theme.font_size) / 2 - theme.font_size / 5;
+
+        out += "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"";
+        number(term.cols() * w);
+        out += "\" height=\"";
+        number(term.rows() * h);
+        out += "\" font-family=\"";
+        out += theme.font_family;
+        out += "\" font-size=\"";
+        number(theme.font_size);
+        out += "\" xml:space=\"preserve\"><style>text{fill:";
+        out += theme.foreground;
+        out += "}.b{font-weight:bold}.i{font-style:italic}.u{text-decoration:underline}";
+
+        // Declaring only the colors used on the screen
+        bool used[16] = {};
+        for (std::size_t r = 0; r < term.rows(); ++r)
+        {
+            for (std::size_t c = 0; c < term.cols(); ++c)
+            {
+                if (auto i = _palette_index((uint8_t)term.at(r, c).attr.get_face(), 30); i >= 0) used[i] = true;
+            }
+        }
+        for (auto i = 0; i < 16; ++i)
+        {
+            if (!used[i]) continue;
+
+            out += ".f";
+            number((std::size_t)i);
+            out += "{fill:";
+            out += theme.palette[i];
+            out += '}';
+        }
+
+        out += "</style><rect width=\"100%\" height=\"100%\" fill=\"";
+        out += theme.background;
+        out += "\"/>";
+
+        for (std::size_t r = 0; r < term.rows(); ++r)
+        {
+            // Background runs
+            for (std::size_t c = 0; c < term.cols();)
+            {
+                auto bg = _palette_index((uint8_t)term.at(r, c).attr.get_back(), 40);
+                auto end = c + 1;
+
+                while (end < term.cols() && _palette_index((uint8_t)term.at(r, end).attr.get_back(), 40) == bg) ++end;
+
+                if (bg >= 0)
+                {
+                    out += "<rect x=\"";
+                    number(c * w);
+                    out += "\" y=\"";
+                    number(r * h);
+                    out += "\" width=\"";
+                    number((end - c) * w);
+                    out += "\" height=\"";
+                    number(h);
+                    out += "\" fill=\"";
+                    out += theme.palette[bg];
+                    out += "\"/>";
+                }
+                c = end;
+            }
+
+            // Text runs; blanks are merged into any neighbor run, as their color is invisible.
+            // Blanks show nothing but the underline, so only the other ones are trimmed
+            auto invisible = [&term, r] (std::size_t c)
+            {
+                auto& cl = term.at(r, c);
+                return cl.ch == U' ' && !((uint8_t)cl.attr.get_style() & (uint8_t)style::underline);
+            };
+
+            auto last = term.cols();
+            while (last && invisible(last - 1)) --last;
+
+            for (std::size_t c = 0; c < last;)
+            {
+                while (c < last && invisible(c)) ++c;
+                if (c == last) break;
+
+                auto attr = term.at(r, c).attr;
+                auto fg = _palette_index((uint8_t)attr.get_face(), 30);
+                auto st = (uint8_t)attr.get_style();
+                auto end = c + 1;
+
+                for (; end < last; ++end)
+                {
+                    auto& cl = term.at(r, end);
+                    auto cl_st = (uint8_t)cl.attr.get_style();
+
+                    if (cl.attr.get_face() != attr.get_face() || cl_st != st)
+                    {
+                        // Blanks show nothing but the underline
+                        if (cl.ch != U' ' || (st | cl_st) & (uint8_t)style::underline) break;
+                    }
+                }
+                // Not drawing blanks at the end of the run
+                auto stop = end;
+                while (invisible(stop - 1)) --stop;
+
+                out += "<text x=\"";
+                number(c * w);
+                out += "\" y=\"";
+                number(r * h + baseline);
+
+                // The font may not match the cell width: fitting the run into its cells
+                out += "\" textLength=\"";
+                number((stop - c) * w);
+                out += "\" lengthAdjust=\"spacingAndGlyphs\"";
+
+                if (fg >= 0 || st)
+                {
+                    out += " class=\"";
+                    auto space = false;
+
+                    auto add = [&] (std::string_view name)
+                    {
+                        if (space) out += ' ';
+                        out += name;
+                        space = true;
+                    };
+                    if (fg >= 0)
+                    {
+                        add("f");
+                        number((std::size_t)fg);
+                    }
+                    if (st & (uint8_t)style::bold) add("b");
+                    if (st & (uint8_t)style::italic) add("i");
+                    if (st & (uint8_t)style::underline) add("u");
+
+                    out += '"';
+                }
+                out += '>';
+
+                for (auto k = c; k < stop; ++k)
+                {
+                    switch (auto ch = term.at(r, k).ch)
+                    {
+                    case U'&': out += "&amp;"; break;
+                    case U'<': out += "&lt;"; break;
+                    case U'>': out += "&gt;"; break;
+
+                    default:
+                        _append_utf8(out, ch);
+                    }
+                }
+                out += "</text>";
+
+                c = end;
+            }
+        }
+        out += "</svg>\n";
+    }
+
+    /**
+     * \brief Renders the output as an SVG image of a terminal screen
+     *
+     * \param output Output bytes (text with escape sequences)
+     * \param rows, cols Screen size
+     * \param theme Colors and metrics
+     *
+     * \return SVG document
+    */
+    [[nodiscard]]
+    inline auto render_svg (std::string_view output, std::size_t rows, std::size_t cols, svg_theme const& theme = xterm_theme) -> std::string
+    {
+        terminal term{ rows, cols };
+        term.write(output);
+
+        std::string out;
+        render_svg(term, out, theme);
+
+        return out;
+    }
+
+}   // end namespace tesc
+
+#endif  // TESC_SVG_H
+
+// MIT License
+//
+// Copyright (c) 2020-2021 Alex Qzminsky
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
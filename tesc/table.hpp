@@ -0,0 +1,359 @@
+#pragma once
+
+// Copyright © 2020-2021 Alex Qzminsky.
+// License: MIT. All rights reserved.
+
+/// \brief Styled table renderer with incremental column measurement
+///
+/// \author https://github.com/qzminsky
+
+#ifndef TESC_TABLE_H
+#define TESC_TABLE_H
+
+#include "../tesc.hpp"
+
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace tesc
+{
+    /**
+     * \class table
+     *
+     * \brief Table of stylized cells
+     *
+     * \details Cells are kept as plain text in a single arena along with a packed `state`.
+     * Column widths are updated as rows are added, so rendering never scans the whole table
+     * and may be done for any window of rows. Border pieces are stylized once when the widths
+     * change, and the rendered rows are assembled into a single buffer
+     *
+     * \note Widths are counted in code points, i.e. wide characters are not taken into account
+    */
+    class table
+    {
+    public:
+
+        /**
+         * \enum align
+         *
+         * \brief Alignment of a column content
+        */
+        enum class align : uint8_t
+        {
+            left, right, center,
+        };
+
+        /**
+         * \struct cell
+         *
+         * \brief Text of a cell with its style
+        */
+        struct cell
+        {
+            std::string_view text;
+            state style = {};
+
+            cell (std::string_view txt, state st = {}) : text{ txt }, style{ st } {}
+            cell (char const* txt, state st = {}) : text{ txt }, style{ st } {}
+            cell (std::string const& txt, state st = {}) : text{ txt }, style{ st } {}
+        };
+
+    private:
+
+        struct _cell
+        {
+            uint32_t offset, size, width;
+            state style;
+        };
+
+        struct _column
+        {
+            std::size_t width = 0;
+            align alignment;
+        };
+
+        std::vector<_column> _columns;
+        std::vector<_cell> _cells;          ///< Row-major cells; the first row is the header
+        std::string _arena;                 ///< Texts of all the cells
+        bool _has_header;
+
+        state _border;
+        std::string _bar;                   ///< Stylized vertical border
+        std::string _rules[3];              ///< Stylized top, header separator and bottom lines
+        bool _rules_valid = false;
+
+    public:
+
+        /**
+         * \brief Constructs a table with a header row
+         *
+         * \param header Header cells
+         * \param border Style of the borders
+        */
+        table (std::initializer_list<cell> header, state border = {})
+            : _columns(header.size(), { 0, align::left })
+            , _has_header{ true }
+        {
+            set_border(border);
+            add_row(header);
+        }
+
+        /**
+         * \brief Constructs a table without a header
+         *
+         * \param columns Number of columns
+         * \param border Style of the borders
+        */
+        explicit table (std::size_t columns, state border = {})
+            : _columns(columns, { 0, align::left })
+            , _has_header{ false }
+        {
+            set_border(border);
+        }
+
+        /**
+         * \brief Changes the style of the borders
+        */
+        auto set_border (state border) -> table&
+        {
+            _border = border;
+
+            _bar.clear();
+            _stylize(_bar, _border, "│");
+            _rules_valid = false;
+
+            return *this;
+        }
+
+        /**
+         * \brief Changes the alignment of a column
+         *
+         * \param column Column index
+         * \param alignment New alignment
+        */
+        auto set_align (std::size_t column, align alignment) -> table&
+        {
+            _columns.at(column).alignment = alignment;
+            return *this;
+        }
+
+        /**
+         * \brief Appends a row
+         *
+         * \param row Row cells (missing trailing cells are empty)
+         *
+         * \throw std::out_of_range if there are more cells than columns
+        */
+        auto add_row (std::initializer_list<cell> row) -> table&
+        {
+            return add_row(row.begin(), row.end());
+        }
+
+        /**
+         * \brief Appends a row
+         *
+         * \param first, last Range of row cells (missing trailing cells are empty)
+         *
+         * \throw std::out_of_range if there are more cells than columns
+        */
+        template <typename It>
+        auto add_row (It first, It last) -> table&
+        {
+            if ((std::size_t)std::distance(first, last) > _columns.size())
+            {
+                throw std::out_of_range{ "tesc::table: too many cells in a row" };
+            }
+
+            for (auto& col : _columns)
+            {
+                _cell c{ (uint32_t)_arena.size(), 0, 0, {} };
+
+                if (first != last)
+                {
+                    cell const& src = *first++;
+
+                    _arena.append(src.text);
+                    c.size = (uint32_t)src.text.size();
+                    c.width = (uint32_t)_width(src.text);
+                    c.style = src.style;
+                }
+                if (c.width > col.width)
+                {
+                    col.width = c.width;
+                    _rules_valid = false;
+                }
+                _cells.push_back(c);
+            }
+            return *this;
+        }
+
+        /**
+         * \brief Returns the number of rows (excluding the header)
+        */
+        [[nodiscard]]
+        auto rows () const -> std::size_t
+        {
+            return _columns.empty() ? 0 : _cells.size() / _columns.size() - _has_header;
+        }
+
+        /**
+         * \brief Returns the current width of a column
+        */
+        [[nodiscard]]
+        auto column_width (std::size_t column) const -> std::size_t
+        {
+            return _columns.at(column).width;
+        }
+
+        /**
+         * \brief Appends a window of rows (with the header and borders) to the buffer
+         *
+         * \param out Output buffer
+         * \param first Index of the first row of the window
+         * \param count Maximal number of rows in the window
+        */
+        void render (std::string& out, std::size_t first = 0, std::size_t count = std::string::npos)
+        {
+            if (_columns.empty()) return;
+            _build_rules();
+
+            auto last = first + std::min(count, rows() - std::min(first, rows()));
+
+            // Reserving approximately to avoid regrowth for the whole window
+            out.reserve(out.size() + (last - first + 4) * (_rules[0].size() + 2 * _columns.size() * 8));
+
+            out += _rules[0];
+            if (_has_header)
+            {
+                _render_row(out, 0);
+                out += _rules[1];
+            }
+            for (auto row = first; row < last; ++row)
+            {
+                _render_row(out, row + _has_header);
+            }
+            out += _rules[2];
+        }
+
+        /**
+         * \brief Writes a window of rows (with the header and borders) to the output stream
+         *
+         * \param os Output stream
+         * \param first Index of the first row of the window
+         * \param count Maximal number of rows in the window
+         *
+         * \return Reference to the output stream
+        */
+        auto print (std::ostream& os, std::size_t first = 0, std::size_t count = std::string::npos) -> std::ostream&
+        {
+            std::string out;
+            render(out, first, count);
+
+            return os.write(out.data(), (std::streamsize)out.size());
+        }
+
+        /**
+         * \brief Writes the whole table to the output stream
+        */
+        friend auto operator << (std::ostream& os, table& tbl) -> std::ostream&
+        {
+            return tbl.print(os);
+        }
+
+    private:
+
+        static auto _width (std::string_view text) -> std::size_t
+        {
+            std::size_t width = 0;
+
+            // Counting everything except UTF-8 continuation bytes
+            for (auto ch : text) width += ((uint8_t)ch & 0xC0) != 0x80;
+
+            return width;
+        }
+
+        static void _stylize (std::string& out, state st, std::string_view text)
+        {
+            if constexpr (enabled) out += transition({}, st).view();
+            out += text;
+            if constexpr (enabled) out += transition(st, {}).view();
+        }
+
+        void _build_rules ()
+        {
+            if (_rules_valid) return;
+
+            std::string_view const pieces[3][3] = {
+                { "┌", "┬", "┐" }, { "├", "┼", "┤" }, { "└", "┴", "┘" },
+            };
+
+            for (auto i = 0; i < 3; ++i)
+            {
+                std::string line;
+                line += pieces[i][0];
+
+                for (std::size_t c = 0; c < _columns.size(); ++c)
+                {
+                    if (c) line += pieces[i][1];
+                    for (std::size_t k = 0; k < _columns[c].width + 2; ++k) line += "─";
+                }
+                line += pieces[i][2];
+
+                _rules[i].clear();
+                _stylize(_rules[i], _border, line);
+                _rules[i] += '\n';
+            }
+            _rules_valid = true;
+        }
+
+        void _render_row (std::string& out, std::size_t row)
+        {
+            auto* cells = &_cells[row * _columns.size()];
+
+            for (std::size_t c = 0; c < _columns.size(); ++c)
+            {
+                auto& cl = cells[c];
+                auto pad = _columns[c].width - cl.width;
+                auto before = _columns[c].alignment == align::right  ? pad
+                            : _columns[c].alignment == align::center ? pad / 2
+                            : 0;
+
+                out += _bar;
+                out.append(before + 1, ' ');
+                _stylize(out, cl.style, { _arena.data() + cl.offset, cl.size });
+                out.append(pad - before + 1, ' ');
+            }
+            out += _bar;
+            out += '\n';
+        }
+    };
+
+}   // end namespace tesc
+
+#endif  // TESC_TABLE_H
+
+// MIT License
+//
+// Copyright (c) 2020-2021 Alex Qzminsky
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
@@ -0,0 +1,287 @@
+#pragma once
+
+// Copyright © 2020-2021 Alex Qzminsky.
+// License: MIT. All rights reserved.
+
+/// \brief Themes of semantic roles with precompiled escape sequences
+///
+/// \author https://github.com/qzminsky
+
+#ifndef TESC_THEME_H
+#define TESC_THEME_H
+
+#include "../tesc.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace tesc
+{
+    /**
+     * \enum role
+     *
+     * \brief Semantic role of a text, styled by the active theme
+    */
+    enum class role : uint8_t
+    {
+        plain, error, warn, info, debug, success, path, number, string, keyword, comment, accent, muted,
+    };
+
+    /// Number of the roles
+    inline constexpr std::size_t role_count = (std::size_t)role::muted + 1;
+
+    /// \internal Names of the roles, indexed by the `role` value
+    inline constexpr std::string_view _role_names[role_count] = {
+        "plain", "error", "warn", "info", "debug", "success", "path", "number", "string", "keyword", "comment", "accent", "muted",
+    };
+
+    /**
+     * \brief Returns the name of the role (e.g. `"error"`)
+    */
+    [[nodiscard]]
+    constexpr auto role_name (role r) -> std::string_view
+    {
+        return _role_names[(std::size_t)r];
+    }
+
+    /**
+     * \brief Finds the role by its name
+     *
+     * \return The role or `std::nullopt` if the name is unknown
+    */
+    [[nodiscard]]
+    constexpr auto parse_role (std::string_view name) -> std::optional<role>
+    {
+        for (std::size_t i = 0; i < role_count; ++i)
+        {
+            if (_role_names[i] == name) return role{ (uint8_t)i };
+        }
+        return std::nullopt;
+    }
+
+    /**
+     * \class theme
+     *
+     * \brief Styles of the roles
+    */
+    class theme
+    {
+        state _styles[role_count];
+
+    public:
+
+        /**
+         * \brief Default constructor. All the roles have the default style
+        */
+        constexpr theme () = default;
+
+        /**
+         * \brief Sets the style of the role
+         *
+         * \return Reference to the theme itself
+        */
+        constexpr auto set (role r, state st) -> theme&
+        {
+            _styles[(std::size_t)r] = st;
+            return *this;
+        }
+
+        /**
+         * \brief Returns the style of the role
+        */
+        [[nodiscard]]
+        constexpr auto get (role r) const -> state
+        {
+            return _styles[(std::size_t)r];
+        }
+    };
+
+    /**
+     * \internal
+     * \brief Builds the built-in theme
+    */
+    constexpr auto _make_default_theme () -> theme
+    {
+        theme th;
+
+        th.set(role::error, { bright(face::red), back::none, style::bold })
+          .set(role::warn, { bright(face::yellow) })
+          .set(role::info, { face::cyan })
+          .set(role::debug, { bright(face::black) })
+          .set(role::success, { face::green })
+          .set(role::path, { bright(face::blue), back::none, style::underline })
+          .set(role::number, { face::magenta })
+          .set(role::string, { face::green })
+          .set(role::keyword, { face::blue, back::none, style::bold })
+          .set(role::comment, { bright(face::black), back::none, style::italic })
+          .set(role::accent, { bright(face::white), back::none, style::bold })
+          .set(role::muted, { bright(face::black) });
+
+        return th;
+    }
+
+    /// Theme which is active until another one is applied
+    inline constexpr theme default_theme = _make_default_theme();
+
+    /**
+     * \class theme_table
+     *
+     * \brief Immutable theme compiled into escape sequences, one per role
+     *
+     * \details Each sequence sets the style completely (`ESC [0;...m`), so it doesn't depend
+     * on the settings which were applied before
+    */
+    class theme_table
+    {
+        theme _theme;
+        escape _escapes[role_count];
+
+    public:
+
+        /**
+         * \brief Compiles the theme
+        */
+        constexpr explicit theme_table (theme const& th) : _theme{ th }
+        {
+            for (std::size_t i = 0; i < role_count; ++i)
+            {
+                auto& seq = _escapes[i];
+                auto delta = transition({}, th.get(role{ (uint8_t)i }));
+
+                seq.push('\033').push('[').push('0');
+
+                // Parameters of the delta from the default state follow the reset
+                for (std::size_t k = 2; k < delta.size(); ++k)
+                {
+                    if (k == 2) seq.push(';');
+                    seq.push(delta.data()[k]);
+                }
+                if (delta.empty()) seq.push('m');
+            }
+        }
+
+        /**
+         * \brief Returns the escape sequence of the role
+        */
+        [[nodiscard]]
+        constexpr auto operator [] (role r) const -> escape const&
+        {
+            return _escapes[(std::size_t)r];
+        }
+
+        /**
+         * \brief Returns the compiled theme
+        */
+        [[nodiscard]]
+        constexpr auto get_theme () const -> theme const&
+        {
+            return _theme;
+        }
+    };
+
+    /// Compiled built-in theme
+    inline constexpr theme_table default_theme_table{ default_theme };
+
+    /// \internal Table of the active theme
+    inline std::atomic<theme_table const*> _active_theme{ &default_theme_table };
+
+    /**
+     * \brief Returns the table of the active theme
+     *
+     * \note The table stays valid until the end of the program
+    */
+    [[nodiscard]]
+    inline auto active_theme () -> theme_table const&
+    {
+        return *_active_theme.load(std::memory_order_acquire);
+    }
+
+    /**
+     * \internal
+     * \brief Keeps the published tables alive: readers may still use a replaced one
+    */
+    inline auto _theme_storage () -> std::pair<std::mutex, std::vector<std::unique_ptr<theme_table const>>>&
+    {
+        static std::pair<std::mutex, std::vector<std::unique_ptr<theme_table const>>> storage;
+        return storage;
+    }
+
+    /**
+     * \brief Makes the theme active for all threads
+     *
+     * \details The theme is compiled before the publication, which is a single atomic pointer
+     * swap, so the emitting threads never see a partially updated theme
+     *
+     * \param th New theme
+    */
+    inline void apply_theme (theme const& th)
+    {
+        auto table = std::make_unique<theme_table const>(th);
+        auto& [mutex, tables] = _theme_storage();
+
+        std::lock_guard lock{ mutex };
+        tables.push_back(std::move(table));
+        _active_theme.store(tables.back().get(), std::memory_order_release);
+    }
+
+    /**
+     * \brief Applies the style of the role in the active theme to the output stream
+     *
+     * \details Takes a single write of a precompiled sequence. Unlike `color` and `font`, doesn't
+     * change their settings. The application goes through the same path as of the manipulators:
+     * a `styling_streambuf` gets it as commands, and the instrumentation counts it as a reset
+     * followed by the changes of the colors and the style which the sequence makes
+     *
+     * \param os Output stream
+     * \param r Role
+     *
+     * \return Reference to the output stream
+    */
+    inline auto operator << (std::ostream& os, role r) -> std::ostream&
+    {
+        if constexpr (!enabled) return os;
+
+        auto const& table = active_theme();
+        auto st = table.get_theme().get(r);
+
+        auto colors = (uint32_t)st.get_face() | (uint32_t)st.get_back() << 8;
+        auto font_style = (uint32_t)st.get_style();
+
+        // The whole sequence goes with the reset it starts from; the settings after it write nothing
+        _emit(os, table[r], _reset_event, 0);
+
+        if (colors) _emit(os, std::string_view{}, _color_event, colors);
+        if (font_style) _emit(os, std::string_view{}, _font_event, font_style);
+
+        return os;
+    }
+
+}   // end namespace tesc
+
+#endif  // TESC_THEME_H
+
+// MIT License
+//
+// Copyright (c) 2020-2021 Alex Qzminsky
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
@@ -0,0 +1,294 @@
+#pragma once
+
+// Copyright © 2020-2021 Alex Qzminsky.
+// License: MIT. All rights reserved.
+
+/// \brief Theme files: parsing, loading and hot reloading
+///
+/// \author https://github.com/qzminsky
+
+#ifndef TESC_THEME_FILE_H
+#define TESC_THEME_FILE_H
+
+#include "paint.hpp"
+#include "theme.hpp"
+
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#if __has_include(<sys/inotify.h>)
+#   include <fcntl.h>
+#   include <poll.h>
+#   include <sys/inotify.h>
+#   define TESC_HAS_INOTIFY 1
+#else
+#   define TESC_HAS_INOTIFY 0
+#endif
+
+namespace tesc
+{
+    /**
+     * \brief Parses a theme file
+     *
+     * \details Each line is `ROLE = STYLE`, where `ROLE` is a name of `role` and `STYLE`
+     * is a `parse_state()` specification. Empty lines and lines starting with `#` are skipped
+     *
+     * \param text Contents of the file
+     * \param base Theme with the styles of the roles not mentioned in the file
+     *
+     * \return Parsed theme
+     *
+     * \throw std::invalid_argument if there is an unknown role or a malformed style
+    */
+    [[nodiscard]]
+    inline auto parse_theme (std::string_view text, theme base = default_theme) -> theme
+    {
+        auto trim = [] (std::string_view str)
+        {
+            auto first = str.find_first_not_of(" \t\r");
+            auto last = str.find_last_not_of(" \t\r");
+
+            return first == str.npos ? std::string_view{} : str.substr(first, last - first + 1);
+        };
+
+        for (std::size_t number = 1; !text.empty(); ++number)
+        {
+            auto end = text.find('\n');
+            auto line = trim(text.substr(0, end));
+            text.remove_prefix(end == text.npos ? text.size() : end + 1);
+
+            if (line.empty() || line[0] == '#') continue;
+
+            auto fail = [&] (std::string const& what) {
+                throw std::invalid_argument{ "tesc::parse_theme: " + what + " at line " + std::to_string(number) };
+            };
+
+            auto eq = line.find('=');
+            if (eq == line.npos) fail("missing '='");
+
+            auto name = trim(line.substr(0, eq));
+            auto spec = trim(line.substr(eq + 1));
+
+            auto r = parse_role(name);
+            if (!r) fail("unknown role '" + std::string{ name } + "'");
+
+            auto st = parse_state(spec);
+            if (!st) fail("invalid style '" + std::string{ spec } + "'");
+
+            base.set(*r, *st);
+        }
+        return base;
+    }
+
+    /**
+     * \brief Reads and parses a theme file
+     *
+     * \param path Path of the file
+     * \param base Theme with the styles of the roles not mentioned in the file
+     *
+     * \throw std::runtime_error if the file cannot be read
+     * \throw std::invalid_argument if the file is malformed
+    */
+    [[nodiscard]]
+    inline auto load_theme (std::string const& path, theme const& base = default_theme) -> theme
+    {
+        std::ifstream file{ path, std::ios::binary };
+        if (!file) throw std::runtime_error{ "tesc::load_theme: cannot open '" + path + "'" };
+
+        std::ostringstream text;
+        text << file.rdbuf();
+
+        return parse_theme(text.str(), base);
+    }
+
+#if TESC_HAS_INOTIFY
+    /**
+     * \class theme_watcher
+     *
+     * \brief Applies a theme file and re-applies it whenever the file changes
+     *
+     * \details A background thread waits for the file changes (by `inotify` on its directory,
+     * so replacing the file by renaming, as editors do, is noticed too), parses and compiles the
+     * theme and publishes it by `apply_theme()`. The emitting threads only load the pointer to
+     * the active table: they never lock and never see a half-updated theme. Replaced tables
+     * are retired, but not freed until the end of the program, as readers may still use them.
+     * A malformed file doesn't change the active theme
+    */
+    class theme_watcher
+    {
+        std::string _path;
+        std::string _name;                      ///< Name of the file in its directory
+        theme _base;
+
+        int _inotify = -1;
+        int _wake[2] = { -1, -1 };              ///< Pipe which stops the thread
+
+        mutable std::mutex _mutex;              ///< Guards the error only
+        std::string _error;
+        std::atomic<unsigned> _reloads{ 0 };
+
+        std::thread _thread;
+
+    public:
+
+        /**
+         * \brief Applies the theme file and starts watching it
+         *
+         * \param path Path of the theme file
+         * \param base Theme with the styles of the roles not mentioned in the file
+         *
+         * \throw std::runtime_error if the watching cannot be set up
+        */
+        explicit theme_watcher (std::string path, theme const& base = default_theme)
+            : _path{ std::move(path) }
+            , _base{ base }
+        {
+            auto slash = _path.rfind('/');
+            auto dir = slash == std::string::npos ? std::string{ "." } : _path.substr(0, slash + !slash);
+            _name = slash == std::string::npos ? _path : _path.substr(slash + 1);
+
+            _inotify = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if (_inotify < 0 || ::pipe2(_wake, O_CLOEXEC) < 0)
+            {
+                _close();
+                throw std::runtime_error{ "tesc::theme_watcher: cannot set up inotify" };
+            }
+            if (::inotify_add_watch(_inotify, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+            {
+                _close();
+                throw std::runtime_error{ "tesc::theme_watcher: cannot watch '" + dir + "'" };
+            }
+
+            reload();
+            _thread = std::thread{ [this] { _run(); } };
+        }
+
+        /// The thread refers to the object
+        theme_watcher (theme_watcher const&) = delete;
+        auto operator = (theme_watcher const&) -> theme_watcher& = delete;
+
+        /**
+         * \brief Destructor. Stops watching; the active theme stays
+        */
+        ~theme_watcher ()
+        {
+            char stop = 0;
+            while (::write(_wake[1], &stop, 1) < 0 && errno == EINTR) {}
+
+            _thread.join();
+            _close();
+        }
+
+        /**
+         * \brief Reads and applies the file immediately
+         *
+         * \return `false` if the file is malformed or cannot be read (see `last_error()`)
+        */
+        auto reload () -> bool
+        {
+            std::string error;
+
+            try {
+                apply_theme(load_theme(_path, _base));
+                _reloads.fetch_add(1, std::memory_order_relaxed);
+            }
+            catch (std::exception const& e) {
+                error = e.what();
+            }
+
+            std::lock_guard lock{ _mutex };
+            _error = std::move(error);
+
+            return _error.empty();
+        }
+
+        /**
+         * \brief Returns the number of successful applications of the file
+        */
+        [[nodiscard]]
+        auto reloads () const -> unsigned
+        {
+            return _reloads.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * \brief Returns the error of the last reading of the file (empty if it was applied)
+        */
+        [[nodiscard]]
+        auto last_error () const -> std::string
+        {
+            std::lock_guard lock{ _mutex };
+            return _error;
+        }
+
+    private:
+
+        void _close ()
+        {
+            for (auto fd : { _inotify, _wake[0], _wake[1] }) if (fd >= 0) ::close(fd);
+        }
+
+        void _run ()
+        {
+            alignas(inotify_event) char events[4096];
+            pollfd fds[] = { { _inotify, POLLIN, 0 }, { _wake[0], POLLIN, 0 } };
+
+            for (;;)
+            {
+                if (::poll(fds, 2, -1) < 0)
+                {
+                    if (errno == EINTR) continue;
+                    return;
+                }
+                if (fds[1].revents) return;
+
+                auto changed = false;
+
+                // Events of other files of the directory are skipped
+                for (ssize_t n; (n = ::read(_inotify, events, sizeof events)) > 0;)
+                {
+                    for (auto* at = events; at < events + n;)
+                    {
+                        auto* event = (inotify_event const*)at;
+                        at += sizeof(inotify_event) + event->len;
+
+                        if (event->len && _name == event->name) changed = true;
+                    }
+                }
+                if (changed) reload();
+            }
+        }
+    };
+#endif
+
+}   // end namespace tesc
+
+#endif  // TESC_THEME_FILE_H
+
+// MIT License
+//
+// Copyright (c) 2020-2021 Alex Qzminsky
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
@@ -0,0 +1,810 @@
+#pragma once
+
+// Copyright © 2020-2021 Alex Qzminsky.
+// License: MIT. All rights reserved.
+
+/// \brief Virtual terminal for headless rendering and testing
+///
+/// \author https://github.com/qzminsky
+
+#ifndef TESC_VT_H
+#define TESC_VT_H
+
+#include "../tesc.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tesc
+{
+    /**
+     * \internal
+     * \brief Appends a code point encoded in UTF-8 to the string
+    */
+    inline void _append_utf8 (std::string& out, char32_t ch)
+    {
+        if (ch < 0x80) out += (char)ch;
+        else if (ch < 0x800)
+        {
+            out += (char)(0xC0 | ch >> 6);
+            out += (char)(0x80 | (ch & 0x3F));
+        }
+        else if (ch < 0x10000)
+        {
+            out += (char)(0xE0 | ch >> 12);
+            out += (char)(0x80 | (ch >> 6 & 0x3F));
+            out += (char)(0x80 | (ch & 0x3F));
+        }
+        else
+        {
+            out += (char)(0xF0 | ch >> 18);
+            out += (char)(0x80 | (ch >> 12 & 0x3F));
+            out += (char)(0x80 | (ch >> 6 & 0x3F));
+            out += (char)(0x80 | (ch & 0x3F));
+        }
+    }
+
+    /**
+     * \class terminal
+     *
+     * \brief In-process terminal emulator which turns output into a grid of stylized cells
+     *
+     * \details Understands printable UTF-8 text, the C0 controls (`\n`, `\r`, `\b`, `\t`),
+     * SGR with the attributes representable by `state`, cursor movements and positioning,
+     * erasing and editing of lines and characters, scrolling regions, cursor saving, `ESC D`,
+     * `ESC M`, `ESC c`. Other sequences (modes, titles...) are consumed and ignored. Rows are
+     * kept in a ring, so scrolling the whole screen costs the clearing of a single row
+     *
+     * \note Every character occupies a single cell; 256 and true colors are ignored
+    */
+    class terminal
+    {
+    public:
+
+        /**
+         * \struct cell
+         *
+         * \brief Character with its attributes
+        */
+        struct cell
+        {
+            char32_t ch = U' ';
+            state attr = {};
+
+            friend constexpr auto operator == (cell const& lhs, cell const& rhs) -> bool
+            {
+                return lhs.ch == rhs.ch && lhs.attr == rhs.attr;
+            }
+
+            friend constexpr auto operator != (cell const& lhs, cell const& rhs) -> bool
+            {
+                return !(lhs == rhs);
+            }
+        };
+
+    private:
+
+        enum class _mode : uint8_t
+        {
+            ground, escape, escape_intermediate, csi, string, string_escape,
+        };
+
+        static constexpr std::size_t _max_params = 16;
+
+        class _buffer : public std::streambuf
+        {
+            terminal& _term;
+
+        public:
+
+            explicit _buffer (terminal& term) : _term{ term } {}
+
+        protected:
+
+            auto overflow (int_type ch) -> int_type override
+            {
+                if (!traits_type::eq_int_type(ch, traits_type::eof()))
+                {
+                    auto c = traits_type::to_char_type(ch);
+                    _term.write({ &c, 1 });
+                }
+                return traits_type::not_eof(ch);
+            }
+
+            auto xsputn (char const* str, std::streamsize n) -> std::streamsize override
+            {
+                _term.write({ str, (std::size_t)n });
+                return n;
+            }
+        };
+
+        std::size_t _rows, _cols;
+        std::vector<cell> _cells;
+        std::size_t _top = 0;                   ///< Ring index of the screen top row
+
+        std::size_t _row = 0, _col = 0;
+        bool _wrap_pending = false;             ///< A character was written to the last column
+        state _pen;
+        std::size_t _scroll_first, _scroll_last;
+        std::size_t _saved_row = 0, _saved_col = 0;
+        state _saved_pen;
+        bool _newline_mode;
+
+        _mode _parser = _mode::ground;
+        unsigned _params[_max_params];
+        std::size_t _nparams = 0;
+        bool _private = false;                  ///< The CSI has a `<=>?` prefix
+
+        char32_t _code = 0;                     ///< UTF-8 decoder state
+        int _need = 0;
+
+        _buffer _buf{ *this };
+
+    public:
+
+        /**
+         * \brief Constructs a terminal with a blank screen
+         *
+         * \param rows, cols Screen size
+         * \param newline_mode Whether `\n` also returns the carriage (as the tty driver does)
+        */
+        terminal (std::size_t rows = 24, std::size_t cols = 80, bool newline_mode = true)
+            : _rows{ std::max<std::size_t>(rows, 1) }
+            , _cols{ std::max<std::size_t>(cols, 1) }
+            , _cells(_rows * _cols)
+            , _scroll_first{ 0 }
+            , _scroll_last{ _rows - 1 }
+            , _newline_mode{ newline_mode }
+        {}
+
+        /// The stream buffer refers to the object
+        terminal (terminal const&) = delete;
+        auto operator = (terminal const&) -> terminal& = delete;
+
+        /**
+         * \brief Returns the number of rows
+        */
+        [[nodiscard]]
+        auto rows () const -> std::size_t
+        {
+            return _rows;
+        }
+
+        /**
+         * \brief Returns the number of columns
+        */
+        [[nodiscard]]
+        auto cols () const -> std::size_t
+        {
+            return _cols;
+        }
+
+        /**
+         * \brief Returns a cell of the screen
+         *
+         * \param row, col Cell position
+         *
+         * \throw std::out_of_range if the position is out of the screen
+        */
+        [[nodiscard]]
+        auto at (std::size_t row, std::size_t col) const -> cell const&
+        {
+            if (row >= _rows || col >= _cols) throw std::out_of_range{ "tesc::terminal: cell is out of the screen" };
+
+            return _line(row)[col];
+        }
+
+        /**
+         * \brief Returns the cursor row
+        */
+        [[nodiscard]]
+        auto cursor_row () const -> std::size_t
+        {
+            return _row;
+        }
+
+        /**
+         * \brief Returns the cursor column
+        */
+        [[nodiscard]]
+        auto cursor_col () const -> std::size_t
+        {
+            return _col;
+        }
+
+        /**
+         * \brief Returns the current attributes of written characters
+        */
+        [[nodiscard]]
+        auto pen () const -> state
+        {
+            return _pen;
+        }
+
+        /**
+         * \brief Returns the text of a row in UTF-8 without trailing spaces
+        */
+        [[nodiscard]]
+        auto line_text (std::size_t row) const -> std::string
+        {
+            std::string text;
+            auto const* line = _line(row);
+
+            for (std::size_t c = 0; c < _cols; ++c) _append_utf8(text, line[c].ch);
+            text.erase(text.find_last_not_of(' ') + 1);
+
+            return text;
+        }
+
+        /**
+         * \brief Returns the text of the screen, row by row, without trailing spaces and empty rows
+        */
+        [[nodiscard]]
+        auto text () const -> std::string
+        {
+            std::string text;
+
+            for (std::size_t r = 0; r < _rows; ++r)
+            {
+                text += line_text(r);
+                text += '\n';
+            }
+            text.erase(text.find_last_not_of('\n') + 1);
+
+            return text;
+        }
+
+        /**
+         * \brief Returns the stream buffer feeding the terminal, e.g. for `std::ostream os{ &term.buffer() }`
+        */
+        [[nodiscard]]
+        auto buffer () -> std::streambuf&
+        {
+            return _buf;
+        }
+
+        /**
+         * \brief Compares the screens (cells and their attributes, but not the cursors)
+        */
+        [[nodiscard]]
+        friend auto operator == (terminal const& lhs, terminal const& rhs) -> bool
+        {
+            if (lhs._rows != rhs._rows || lhs._cols != rhs._cols) return false;
+
+            for (std::size_t r = 0; r < lhs._rows; ++r)
+            {
+                if (!std::equal(lhs._line(r), lhs._line(r) + lhs._cols, rhs._line(r))) return false;
+            }
+            return true;
+        }
+
+        [[nodiscard]]
+        friend auto operator != (terminal const& lhs, terminal const& rhs) -> bool
+        {
+            return !(lhs == rhs);
+        }
+
+        /**
+         * \brief Feeds the output to the terminal
+         *
+         * \param bytes Output bytes; sequences may be split between the calls
+        */
+        void write (std::string_view bytes)
+        {
+            auto const* p = bytes.data();
+            auto const* end = p + bytes.size();
+
+            while (p != end)
+            {
+                if (_parser == _mode::ground && !_need)
+                {
+                    // The fast path: a run of printable ASCII characters
+                    auto const* run = p;
+                    while (run != end && (uint8_t)*run >= 0x20 && (uint8_t)*run < 0x7F) ++run;
+
+                    if (run != p)
+                    {
+                        _print_ascii(p, run);
+                        p = run;
+                        continue;
+                    }
+
+                    // Another one: a whole CSI sequence without a prefix
+                    if (*p == 0x1B && end - p > 2 && p[1] == '[')
+                    {
+                        if (auto const* next = _csi_at_once(p + 2, end))
+                        {
+                            p = next;
+                            continue;
+                        }
+                    }
+                }
+                _consume((uint8_t)*p++);
+            }
+        }
+
+        /**
+         * \brief Feeds the output to the terminal
+        */
+        friend auto operator << (terminal& term, std::string_view bytes) -> terminal&
+        {
+            term.write(bytes);
+            return term;
+        }
+
+        /**
+         * \brief Returns the terminal to the initial state
+        */
+        void reset ()
+        {
+            std::fill(_cells.begin(), _cells.end(), cell{});
+
+            _top = _row = _col = 0;
+            _wrap_pending = false;
+            _pen = _saved_pen = {};
+            _saved_row = _saved_col = 0;
+            _scroll_first = 0;
+            _scroll_last = _rows - 1;
+            _parser = _mode::ground;
+            _need = 0;
+        }
+
+    private:
+
+        auto _line (std::size_t row) -> cell*
+        {
+            return &_cells[(_top + row) % _rows * _cols];
+        }
+
+        auto _line (std::size_t row) const -> cell const*
+        {
+            return &_cells[(_top + row) % _rows * _cols];
+        }
+
+        auto _blank () const -> cell
+        {
+            // Erased cells take the current background
+            return { U' ', state{ face::none, _pen.get_back(), style::normal } };
+        }
+
+        void _print_ascii (char const* first, char const* last)
+        {
+            while (first != last)
+            {
+                if (_wrap_pending) _wrap();
+
+                auto* line = _line(_row);
+                auto n = std::min((std::size_t)(last - first), _cols - _col);
+
+                for (std::size_t i = 0; i < n; ++i) line[_col + i] = { (char32_t)(uint8_t)first[i], _pen };
+
+                first += n;
+                _col += n;
+
+                if (_col == _cols)
+                {
+                    _col = _cols - 1;
+                    _wrap_pending = true;
+                }
+            }
+        }
+
+        void _print (char32_t ch)
+        {
+            if (_wrap_pending) _wrap();
+
+            _line(_row)[_col] = { ch, _pen };
+
+            if (_col + 1 == _cols) _wrap_pending = true;
+            else ++_col;
+        }
+
+        void _wrap ()
+        {
+            _wrap_pending = false;
+            _col = 0;
+            _line_feed();
+        }
+
+        void _line_feed ()
+        {
+            if (_row == _scroll_last) _scroll_up(1);
+            else if (_row + 1 < _rows) ++_row;
+        }
+
+        void _reverse_line_feed ()
+        {
+            if (_row == _scroll_first) _scroll_down(1);
+            else if (_row) --_row;
+        }
+
+        void _scroll_up (std::size_t n)
+        {
+            n = std::min(n, _scroll_last - _scroll_first + 1);
+
+            if (_scroll_first == 0 && _scroll_last == _rows - 1)
+            {
+                // The whole screen: rotating the ring
+                for (std::size_t i = 0; i < n; ++i)
+                {
+                    std::fill_n(_line(0), _cols, _blank());
+                    _top = (_top + 1) % _rows;
+                }
+                return;
+            }
+            for (auto r = _scroll_first; r + n <= _scroll_last; ++r) std::copy_n(_line(r + n), _cols, _line(r));
+            for (auto r = _scroll_last + 1 - n; r <= _scroll_last; ++r) std::fill_n(_line(r), _cols, _blank());
+        }
+
+        void _scroll_down (std::size_t n)
+        {
+            n = std::min(n, _scroll_last - _scroll_first + 1);
+
+            for (auto r = _scroll_last; r >= _scroll_first + n; --r) std::copy_n(_line(r - n), _cols, _line(r));
+            for (auto r = _scroll_first; r < _scroll_first + n; ++r) std::fill_n(_line(r), _cols, _blank());
+        }
+
+        /**
+         * \brief Executes a CSI sequence if it is complete in the buffer
+         *
+         * \return Pointer past the sequence or `nullptr` if it needs the state machine
+        */
+        auto _csi_at_once (char const* p, char const* end) -> char const*
+        {
+            _nparams = 0;
+            _private = false;
+
+            for (unsigned value = 0, digits = 0; p != end; ++p)
+            {
+                auto ch = (uint8_t)*p;
+
+                if (ch >= '0' && ch <= '9')
+                {
+                    value = std::min(value * 10 + (ch - '0'), 65535u);
+                    ++digits;
+                    continue;
+                }
+                if (ch != ';' && ch != ':' && (ch < 0x40 || ch > 0x7E)) return nullptr;
+
+                if (_nparams < _max_params && (digits || ch == ';' || ch == ':' || _nparams)) _params[_nparams++] = value;
+                if (ch >= 0x40)
+                {
+                    _dispatch_csi((char)ch);
+                    return p + 1;
+                }
+                value = digits = 0;
+            }
+            return nullptr;
+        }
+
+        void _consume (uint8_t ch)
+        {
+            switch (_parser)
+            {
+            case _mode::ground:
+                return _ground(ch);
+
+            case _mode::escape:
+                return _escape(ch);
+
+            case _mode::escape_intermediate:
+                // The final byte of an ignored sequence (e.g. charset selection, `ESC # 8`)
+                if (ch >= 0x20 && ch <= 0x2F) return;
+
+                _parser = _mode::ground;
+                if (ch < 0x30 || ch > 0x7E) _ground(ch);   // An interrupted sequence
+                return;
+
+            case _mode::csi:
+                if (ch >= '0' && ch <= '9')
+                {
+                    auto& p = _params[_nparams ? _nparams - 1 : 0];
+                    if (!_nparams) _nparams = 1, p = 0;
+
+                    p = std::min(p * 10 + (ch - '0'), 65535u);
+                }
+                else if (ch == ';' || ch == ':')
+                {
+                    if (!_nparams) _params[_nparams++] = 0;
+                    if (_nparams < _max_params) _params[_nparams++] = 0;
+                }
+                else if (ch >= '<' && ch <= '?') _private = true;
+                else if (ch >= 0x40 && ch <= 0x7E)
+                {
+                    _parser = _mode::ground;
+                    _dispatch_csi((char)ch);
+                }
+                else if (ch < 0x20 || ch > 0x2F)
+                {
+                    // An interrupted sequence
+                    _parser = _mode::ground;
+                    _ground(ch);
+                }
+                return;
+
+            case _mode::string:
+                if (ch == '\a') _parser = _mode::ground;
+                else if (ch == 0x1B) _parser = _mode::string_escape;
+                return;
+
+            case _mode::string_escape:
+                _parser = ch == '\\' ? _mode::ground : _mode::string;
+                return;
+            }
+        }
+
+        void _ground (uint8_t ch)
+        {
+            if (_need)
+            {
+                if ((ch & 0xC0) == 0x80)
+                {
+                    _code = _code << 6 | (ch & 0x3F);
+                    if (!--_need) _print(_code);
+                    return;
+                }
+                // A truncated character
+                _need = 0;
+                _print(U'\uFFFD');
+            }
+
+            if (ch >= 0x80)
+            {
+                if (ch >= 0xC2 && ch <= 0xF4)
+                {
+                    _need = ch >= 0xF0 ? 3 : ch >= 0xE0 ? 2 : 1;
+                    _code = ch & (0x3F >> _need);
+                }
+                else _print(U'\uFFFD');
+
+                return;
+            }
+
+            switch (ch)
+            {
+            case 0x1B: _parser = _mode::escape; break;
+            case '\n':
+            case '\v':
+            case '\f':
+                if (_newline_mode) _col = 0;
+                _wrap_pending = false;
+                _line_feed();
+                break;
+
+            case '\r': _col = 0; _wrap_pending = false; break;
+            case '\b': if (_col) --_col; _wrap_pending = false; break;
+            case '\t': _col = std::min((_col / 8 + 1) * 8, _cols - 1); break;
+
+            default:
+                if (ch >= 0x20 && ch < 0x7F) _print(ch);
+            }
+        }
+
+        void _escape (uint8_t ch)
+        {
+            _parser = _mode::ground;
+
+            switch (ch)
+            {
+            case '[':
+                _parser = _mode::csi;
+                _nparams = 0;
+                _private = false;
+                break;
+
+            case ']': case 'P': case 'X': case '^': case '_':
+                _parser = _mode::string;
+                break;
+
+            case '7': _save(); break;
+            case '8': _restore(); break;
+            case 'D': _line_feed(); break;
+            case 'E': _col = 0; _line_feed(); break;
+            case 'M': _reverse_line_feed(); break;
+            case 'c': reset(); break;
+
+            default:
+                // Intermediate bytes are followed by the final one, which is ignored
+                if (ch >= 0x20 && ch <= 0x2F) _parser = _mode::escape_intermediate;
+            }
+        }
+
+        void _save ()
+        {
+            _saved_row = _row;
+            _saved_col = _col;
+            _saved_pen = _pen;
+        }
+
+        void _restore ()
+        {
+            _row = _saved_row;
+            _col = _saved_col;
+            _pen = _saved_pen;
+            _wrap_pending = false;
+        }
+
+        auto _param (std::size_t i, unsigned fallback) const -> unsigned
+        {
+            return i < _nparams && _params[i] ? _params[i] : fallback;
+        }
+
+        void _erase (std::size_t row, std::size_t first, std::size_t last)
+        {
+            std::fill(_line(row) + first, _line(row) + last, _blank());
+        }
+
+        void _dispatch_csi (char final)
+        {
+            if (_private) return;   // Modes and queries
+
+            // Unlike the other sequences, SGR doesn't cancel the pending wrap
+            if (final == 'm') return _sgr();
+
+            auto n = (std::size_t)_param(0, 1);
+            _wrap_pending = false;
+
+            switch (final)
+            {
+            case 'A': {
+                // The cursor doesn't leave the scrolling region by these movements
+                auto floor = _row >= _scroll_first ? _scroll_first : 0;
+                _row = _row >= floor + n ? _row - n : floor;
+                break;
+            }
+            case 'B': _row = std::min(_row + n, _row <= _scroll_last ? _scroll_last : _rows - 1); break;
+            case 'C': _col = std::min(_col + n, _cols - 1); break;
+            case 'D': _col = _col > n ? _col - n : 0; break;
+            case 'E': _row = std::min(_row + n, _rows - 1); _col = 0; break;
+            case 'F': _row = _row > n ? _row - n : 0; _col = 0; break;
+            case 'G': case '`': _col = std::min(n, _cols) - 1; break;
+            case 'd': _row = std::min(n, _rows) - 1; break;
+
+            case 'H': case 'f':
+                _row = std::min((std::size_t)_param(0, 1), _rows) - 1;
+                _col = std::min((std::size_t)_param(1, 1), _cols) - 1;
+                break;
+
+            case 'J':
+                switch (_param(0, 0))
+                {
+                case 0:
+                    _erase(_row, _col, _cols);
+                    for (auto r = _row + 1; r < _rows; ++r) _erase(r, 0, _cols);
+                    break;
+                case 1:
+                    for (std::size_t r = 0; r < _row; ++r) _erase(r, 0, _cols);
+                    _erase(_row, 0, _col + 1);
+                    break;
+                default:
+                    for (std::size_t r = 0; r < _rows; ++r) _erase(r, 0, _cols);
+                }
+                break;
+
+            case 'K':
+                switch (_param(0, 0))
+                {
+                case 0: _erase(_row, _col, _cols); break;
+                case 1: _erase(_row, 0, _col + 1); break;
+                default: _erase(_row, 0, _cols);
+                }
+                break;
+
+            case 'X': _erase(_row, _col, std::min(_col + n, _cols)); break;
+
+            case '@': {
+                auto* line = _line(_row);
+                n = std::min(n, _cols - _col);
+
+                std::copy_backward(line + _col, line + _cols - n, line + _cols);
+                std::fill_n(line + _col, n, _blank());
+                break;
+            }
+            case 'P': {
+                auto* line = _line(_row);
+                n = std::min(n, _cols - _col);
+
+                std::copy(line + _col + n, line + _cols, line + _col);
+                std::fill(line + _cols - n, line + _cols, _blank());
+                break;
+            }
+            case 'L': case 'M':
+                if (_row >= _scroll_first && _row <= _scroll_last)
+                {
+                    auto first = _scroll_first;
+                    _scroll_first = _row;
+
+                    if (final == 'L') _scroll_down(n);
+                    else _scroll_up(n);
+
+                    _scroll_first = first;
+                    _col = 0;
+                }
+                break;
+
+            case 'S': _scroll_up(n); break;
+            case 'T': _scroll_down(n); break;
+
+            case 'r': {
+                auto first = (std::size_t)_param(0, 1) - 1;
+                auto last = std::min((std::size_t)_param(1, (unsigned)_rows), _rows) - 1;
+
+                if (first < last)
+                {
+                    _scroll_first = first;
+                    _scroll_last = last;
+                    _row = _col = 0;
+                }
+                break;
+            }
+            case 's': _save(); break;
+            case 'u': _restore(); break;
+            }
+        }
+
+        void _sgr ()
+        {
+            auto fg = _pen.get_face();
+            auto bg = _pen.get_back();
+            auto st = (uint8_t)_pen.get_style();
+
+            if (!_nparams) _params[_nparams++] = 0;
+
+            for (std::size_t i = 0; i < _nparams; ++i)
+            {
+                auto p = _params[i];
+
+                switch (p)
+                {
+                case 0: fg = face::none; bg = back::none; st = 0; break;
+                case 1: st |= (uint8_t)style::bold; break;
+                case 3: st |= (uint8_t)style::italic; break;
+                case 4: st |= (uint8_t)style::underline; break;
+                case 22: st &= (uint8_t)~(uint8_t)style::bold; break;
+                case 23: st &= (uint8_t)~(uint8_t)style::italic; break;
+                case 24: st &= (uint8_t)~(uint8_t)style::underline; break;
+                case 39: fg = face::none; break;
+                case 49: bg = back::none; break;
+
+                case 38: case 48:
+                    // Extended colors can't be represented: skipping their arguments
+                    if (i + 1 < _nparams) i += _params[i + 1] == 5 ? 2 : _params[i + 1] == 2 ? 4 : 1;
+                    break;
+
+                default:
+                    if ((p >= 30 && p <= 37) || (p >= 90 && p <= 97)) fg = face{ (uint8_t)p };
+                    else if ((p >= 40 && p <= 47) || (p >= 100 && p <= 107)) bg = back{ (uint8_t)p };
+                }
+            }
+            _pen = state{ fg, bg, style{ st } };
+        }
+    };
+
+}   // end namespace tesc
+
+#endif  // TESC_VT_H
+
+// MIT License
+//
+// Copyright (c) 2020-2021 Alex Qzminsky
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
@@ -0,0 +1,563 @@
+#pragma once
+
+// Copyright © 2020-2021 Alex Qzminsky.
+// License: MIT. All rights reserved.
+
+/// \brief Wrapping of styled text to the terminal width
+///
+/// \author https://github.com/qzminsky
+
+#ifndef TESC_WRAP_H
+#define TESC_WRAP_H
+
+#include "../tesc.hpp"
+#include "ansi.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace tesc
+{
+    /**
+     * \internal
+     * \struct _sgr_state
+     *
+     * \brief SGR attributes in effect, including the extended colors
+    */
+    struct _sgr_state
+    {
+        uint16_t attributes = 0;                ///< Bits of the parameters 1 to 9
+        uint8_t fg_size = 0, bg_size = 0;
+        char fg[24], bg[24];                    ///< Color parameters (e.g. `31` or `38;2;r;g;b`)
+
+        [[nodiscard]]
+        auto empty () const -> bool
+        {
+            return !attributes && !fg_size && !bg_size;
+        }
+
+        [[nodiscard]]
+        friend auto operator == (_sgr_state const& lhs, _sgr_state const& rhs) -> bool
+        {
+            return lhs.attributes == rhs.attributes
+                && std::string_view{ lhs.fg, lhs.fg_size } == std::string_view{ rhs.fg, rhs.fg_size }
+                && std::string_view{ lhs.bg, lhs.bg_size } == std::string_view{ rhs.bg, rhs.bg_size };
+        }
+
+        /**
+         * \brief Applies the parameters of an SGR sequence (between `ESC [` and `m`)
+         *
+         * \details Empty parameters, including the trailing one (`ESC [1;m`), stand for 0
+        */
+        void apply (std::string_view params)
+        {
+            auto more = true;                   // A parameter follows, maybe an empty one
+
+            auto next = [&params, &more] () -> std::string_view
+            {
+                auto end = params.find(';');
+                auto param = params.substr(0, end);
+
+                more = end != params.npos;
+                params.remove_prefix(more ? end + 1 : params.size());
+                return param;
+            };
+
+            auto set = [] (char* text, uint8_t& size, std::string_view param)
+            {
+                size = (uint8_t)std::min(param.size(), sizeof fg);
+                std::memcpy(text, param.data(), size);
+            };
+
+            do
+            {
+                auto param = next();
+                unsigned p = 0;
+
+                for (auto ch : param)
+                {
+                    if (ch < '0' || ch > '9' || p > 1000) break;
+                    p = p * 10 + (unsigned)(ch - '0');
+                }
+
+                switch (p)
+                {
+                case 0: *this = {}; break;
+                case 21: case 22: attributes &= (uint16_t)~(1u << 1 | 1u << 2); break;
+                case 23: case 24: case 27: case 28: case 29: attributes &= (uint16_t)~(1u << (p - 20)); break;
+                case 25: attributes &= (uint16_t)~(1u << 5 | 1u << 6); break;
+                case 39: fg_size = 0; break;
+                case 49: bg_size = 0; break;
+
+                case 38: case 48:
+                {
+                    // `38;5;n`, `38;2;r;g;b` or a single `38:...` parameter
+                    auto end = param.data() + param.size();
+
+                    if (param.find(':') == param.npos && more)
+                    {
+                        auto kind = next();
+                        auto count = kind == "5" ? 1 : kind == "2" ? 3 : 0;
+
+                        for (end = kind.data() + kind.size(); count-- && more;)
+                        {
+                            auto arg = next();
+                            end = arg.data() + arg.size();
+                        }
+                    }
+                    p == 38 ? set(fg, fg_size, { param.data(), (std::size_t)(end - param.data()) })
+                            : set(bg, bg_size, { param.data(), (std::size_t)(end - param.data()) });
+                    break;
+                }
+
+                default:
+                    if (p >= 1 && p <= 9) attributes |= (uint16_t)(1u << p);
+                    else if ((p >= 30 && p <= 37) || (p >= 90 && p <= 97)) set(fg, fg_size, param);
+                    else if ((p >= 40 && p <= 47) || (p >= 100 && p <= 107)) set(bg, bg_size, param);
+                }
+            }
+            while (more);
+        }
+
+        /**
+         * \brief Writes the sequence which sets the state from the default one
+        */
+        void write (std::string& out) const
+        {
+            if (empty()) return;
+
+            out += "\033[";
+            auto first = true;
+
+            auto put = [&] (std::string_view param)
+            {
+                if (!first) out += ';';
+                out += param;
+                first = false;
+            };
+
+            for (unsigned p = 1; p <= 9; ++p)
+            {
+                if (attributes & (1u << p)) put(std::string_view{ "123456789" + (p - 1), 1 });
+            }
+            if (fg_size) put({ fg, fg_size });
+            if (bg_size) put({ bg, bg_size });
+
+            out += 'm';
+        }
+    };
+
+    /**
+     * \class line_wrapper
+     *
+     * \brief Streaming wrapper of styled text to lines of the given width
+     *
+     * \details SGR sequences are tracked while the visible width is measured. Lines are broken
+     * at spaces, or within a word which is longer than a line. Each output line is self-contained:
+     * the style in effect is reset at its end and re-applied at the start of the next one, so
+     * any line may be shown alone (e.g. by a pager). Only the current word and the spaces before
+     * it are kept, so the memory doesn't depend on the input length
+     *
+     * \note Widths are counted in code points, i.e. wide characters are not taken into account.
+     * Tabs are expanded to the multiples of 8. SGR attributes other than colors and the
+     * parameters 1 to 9 are passed, but not re-applied on the continuation lines
+    */
+    class line_wrapper
+    {
+        static constexpr std::size_t _max_partial = 4096;
+
+        std::size_t _width;
+        std::size_t _column = 0;                ///< Visible width of the written part of the line
+        bool _line_started = false;             ///< The style is re-applied on the line
+
+        _sgr_state _written;                    ///< State after the written output
+        _sgr_state _word_start;                 ///< State before the first character of the word
+        _sgr_state _current;                    ///< State after the whole input
+
+        std::string _gap;                       ///< Spaces (and sequences among them) before the word
+        std::size_t _gap_width = 0;
+        std::string _word;
+        std::size_t _word_width = 0;
+        std::size_t _sgr_tail = std::string::npos;  ///< Start of the trailing SGR sequences of the buffer
+        _sgr_state _tail_start;                 ///< State before them
+
+        std::string _partial;                   ///< Incomplete sequence from the previous input
+
+    public:
+
+        /**
+         * \brief Constructs the wrapper
+         *
+         * \param width Maximal visible width of the lines
+         *
+         * \throw std::invalid_argument if the width is zero
+        */
+        explicit line_wrapper (std::size_t width) : _width{ width }
+        {
+            if (!width) throw std::invalid_argument{ "tesc::line_wrapper: zero width" };
+        }
+
+        /**
+         * \brief Wraps the next part of the input
+         *
+         * \param in Input bytes; sequences may be split between the calls
+         * \param out Output buffer
+        */
+        void feed (std::string_view in, std::string& out)
+        {
+            if (!_partial.empty())
+            {
+                // Completing the sequence byte by byte
+                while (!in.empty())
+                {
+                    _partial += in.front();
+                    in.remove_prefix(1);
+
+                    if (sequence_length(_partial, 0) != std::string_view::npos || _partial.size() >= _max_partial) break;
+                }
+                if (sequence_length(_partial, 0) == std::string_view::npos && _partial.size() < _max_partial) return;
+
+                _sequence(_partial);
+                _partial.clear();
+            }
+
+            for (std::size_t pos = 0; pos < in.size();)
+            {
+                auto ch = in[pos];
+
+                if (ch != '\033')
+                {
+                    _char(ch, out);
+                    ++pos;
+                    continue;
+                }
+
+                auto len = sequence_length(in, pos);
+                if (len == std::string_view::npos)
+                {
+                    _partial.assign(in.substr(pos));
+                    return;
+                }
+
+                _sequence(in.substr(pos, len));
+                pos += len;
+            }
+        }
+
+        /**
+         * \brief Writes the pending word and closes the style of the last line
+         *
+         * \param out Output buffer
+        */
+        void finish (std::string& out)
+        {
+            _commit(out);
+            _emit_gap(out);
+
+            _word += _partial;
+            _partial.clear();
+            _emit_word(out);
+
+            if (!_written.empty()) out += "\033[0m";
+
+            _column = 0;
+            _line_started = false;
+            _sgr_tail = std::string::npos;
+            _written = _word_start = _current = {};
+        }
+
+    private:
+
+        void _char (char ch, std::string& out)
+        {
+            switch (ch)
+            {
+            case '\n':
+                _sgr_tail = std::string::npos;
+                _commit(out);
+                _emit_gap(out);
+                _break(out);
+                return;
+
+            case ' ': case '\t':
+            {
+                if (!_word.empty()) _sgr_tail = std::string::npos;
+                _commit(out);
+
+                auto spaces = ch == ' ' ? 1 : 8 - (_column + _gap_width) % 8;
+
+                // Spaces beyond the end of the line are dropped and don't separate the sequences
+                // around them, so these are merged into one and the gap stays bounded
+                for (; spaces && _column + _gap_width < _width; --spaces, ++_gap_width)
+                {
+                    _gap += ' ';
+                    _sgr_tail = std::string::npos;
+                }
+                return;
+            }
+            }
+
+            _sgr_tail = std::string::npos;
+            if (_word.empty()) _word_start = _current;
+
+            // Continuation bytes of UTF-8 and controls take no columns
+            if (((uint8_t)ch & 0xC0) != 0x80 && (uint8_t)ch >= 0x20)
+            {
+                if (_column + _gap_width + _word_width + 1 > _width)
+                {
+                    if (_column)
+                    {
+                        // The word goes to the next line
+                        _break(out);
+                    }
+                    else if (_gap_width)
+                    {
+                        // The word wouldn't fit a line after its indentation either
+                        _drop_gap(out);
+                    }
+                    else
+                    {
+                        // The word is longer than a line: it is broken at the last column
+                        _emit_gap(out);
+                        _emit_word(out);
+                        _break(out);
+                        _word_start = _current;
+                    }
+                }
+                ++_word_width;
+            }
+            _word += ch;
+        }
+
+        void _sequence (std::string_view seq)
+        {
+            auto& buffer = _word.empty() ? _gap : _word;
+
+            if (seq.size() < 3 || seq[1] != '[' || seq.back() != 'm')
+            {
+                buffer += seq;
+                _sgr_tail = std::string::npos;
+                return;
+            }
+            if (_sgr_tail == std::string::npos)
+            {
+                _sgr_tail = buffer.size();
+                _tail_start = _current;
+            }
+            _current.apply(seq.substr(2, seq.size() - 3));
+
+            // Back-to-back SGR sequences are replaced by the single one of the resulting state
+            buffer.resize(_sgr_tail);
+
+            if (_current == _tail_start) return;
+            if (!_tail_start.empty()) buffer += "\033[0m";
+
+            _current.write(buffer);
+        }
+
+        /// Writes the word after the gap, on this line or on the next one
+        void _commit (std::string& out)
+        {
+            if (_word.empty()) return;
+
+            if (_column + _gap_width + _word_width > _width) _break(out);
+
+            _emit_gap(out);
+            _emit_word(out);
+        }
+
+        void _start_line (std::string& out)
+        {
+            if (_line_started) return;
+
+            _written.write(out);
+            _line_started = true;
+        }
+
+        void _emit_gap (std::string& out)
+        {
+            if (_gap.empty()) return;
+
+            _start_line(out);
+            out += _gap;
+            _column += _gap_width;
+
+            _gap.clear();
+            _gap_width = 0;
+            _written = _word.empty() ? _current : _word_start;
+        }
+
+        void _emit_word (std::string& out)
+        {
+            if (_word.empty()) return;
+
+            _start_line(out);
+            out += _word;
+            _column += _word_width;
+
+            _word.clear();
+            _word_width = 0;
+            _written = _current;
+        }
+
+        /// Drops the spaces before the word; the sequences among them are applied
+        void _drop_gap (std::string& out)
+        {
+            if (_gap.empty()) return;
+
+            auto target = _word.empty() ? _current : _word_start;
+
+            if (_line_started && !(target == _written))
+            {
+                if (!_written.empty()) out += "\033[0m";
+                target.write(out);
+            }
+            _gap.clear();
+            _gap_width = 0;
+            _written = target;
+        }
+
+        /// Ends the line; the spaces before the word are dropped
+        void _break (std::string& out)
+        {
+            if (_line_started && !_written.empty()) out += "\033[0m";
+
+            out += '\n';
+            _column = 0;
+            _line_started = false;
+
+            _drop_gap(out);
+        }
+    };
+
+    /**
+     * \brief Wraps styled text to lines of the given width
+     *
+     * \param in Input text
+     * \param width Maximal visible width of the lines
+     *
+     * \return Wrapped text; each line has its own style sequences
+    */
+    [[nodiscard]]
+    inline auto wrap_lines (std::string_view in, std::size_t width) -> std::string
+    {
+        std::string out;
+        out.reserve(in.size() + in.size() / width + 16);
+
+        line_wrapper wrapper{ width };
+        wrapper.feed(in, out);
+        wrapper.finish(out);
+
+        return out;
+    }
+
+    /**
+     * \class wrapping_buffer
+     *
+     * \brief Stream buffer which wraps the text on the way to the target one
+     *
+     * \details A flush writes everything but the last word, which may yet go to the next line
+    */
+    class wrapping_buffer : public std::streambuf
+    {
+        std::streambuf* _target;
+        line_wrapper _wrapper;
+        std::string _out;
+        char _area[4096];
+
+    public:
+
+        /**
+         * \brief Constructs the buffer
+         *
+         * \param target Stream buffer to write the wrapped output to
+         * \param width Maximal visible width of the lines
+        */
+        wrapping_buffer (std::streambuf* target, std::size_t width) : _target{ target }, _wrapper{ width }
+        {
+            setp(_area, _area + sizeof _area);
+        }
+
+        /// The put area refers to the object
+        wrapping_buffer (wrapping_buffer const&) = delete;
+        auto operator = (wrapping_buffer const&) -> wrapping_buffer& = delete;
+
+        /**
+         * \brief Destructor. Writes the pending output
+        */
+        ~wrapping_buffer () override
+        {
+            _feed();
+            _wrapper.finish(_out);
+
+            _write();
+            _target->pubsync();
+        }
+
+    protected:
+
+        auto overflow (int_type ch) -> int_type override
+        {
+            _feed();
+
+            if (!_write()) return traits_type::eof();
+            if (traits_type::eq_int_type(ch, traits_type::eof())) return traits_type::not_eof(ch);
+
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+
+            return ch;
+        }
+
+        auto sync () -> int override
+        {
+            _feed();
+            return _write() ? _target->pubsync() : -1;
+        }
+
+    private:
+
+        void _feed ()
+        {
+            _wrapper.feed({ pbase(), (std::size_t)(pptr() - pbase()) }, _out);
+            setp(_area, _area + sizeof _area);
+        }
+
+        auto _write () -> bool
+        {
+            auto n = (std::streamsize)_out.size();
+            auto res = n ? _target->sputn(_out.data(), n) : 0;
+            _out.clear();
+
+            return res == n;
+        }
+    };
+
+}   // end namespace tesc
+
+#endif  // TESC_WRAP_H
+
+// MIT License
+//
+// Copyright (c) 2020-2021 Alex Qzminsky
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
@@ -0,0 +1,51 @@
+// Copyright © 2020-2021 Alex Qzminsky.
+// License: MIT. All rights reserved.
+
+/// \brief Checks that a `TESC_DISABLE` build writes the plain text only and stores no settings
+
+#include "tesc.hpp"
+#include "tesc/gradient.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+using namespace tesc;
+
+static_assert(!enabled, "the test is built with TESC_DISABLE");
+
+int main ()
+{
+    std::ostringstream os;
+
+    os << color{ face::red | back::blue } << "plain " << font{ style::bold | style::italic } << "text"
+       << color{ back::green } << '!' << reset << color{ face::none | back::none };
+
+    if (os.str() != "plain text!")
+    {
+        std::fprintf(stderr, "unexpected output: '%s'\n", os.str().c_str());
+        return EXIT_FAILURE;
+    }
+
+    if (color::get_face() != face::none || color::get_back() != back::none || font::get_style() != style::normal)
+    {
+        std::fprintf(stderr, "settings are stored\n");
+        return EXIT_FAILURE;
+    }
+
+    // Renderers which build the sequences themselves write the text only
+    gradient g{ { { 255, 0, 0 }, { 0, 0, 255 } } };
+    std::string painted;
+
+    g.render("plain", painted);
+    double values[] = { 0, 0.5, 1 };
+    heatmap{ g, 0, 1 }.render(values, 3, painted, "#");
+
+    if (painted != "plain###")
+    {
+        std::fprintf(stderr, "unexpected gradient output: '%s'\n", painted.c_str());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
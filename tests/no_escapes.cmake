@@ -0,0 +1,17 @@
+# Fails if the file contains a control sequence introducer (ESC '['); a lone ESC byte
+# is not checked, as it is common in machine code and unwinding tables
+#
+# Usage: cmake -DFILE=<path> -P no_escapes.cmake
+
+file(READ "${FILE}" contents HEX)
+string(LENGTH "${contents}" length)
+
+set(offset 0)
+while(offset LESS length)
+    string(SUBSTRING "${contents}" ${offset} 4 bytes)
+    if(bytes STREQUAL "1b5b")
+        math(EXPR position "${offset} / 2")
+        message(FATAL_ERROR "Escape sequence at offset ${position} of ${FILE}")
+    endif()
+    math(EXPR offset "${offset} + 2")
+endwhile()
@@ -0,0 +1,81 @@
+// Copyright © 2020-2021 Alex Qzminsky.
+// License: MIT. All rights reserved.
+
+/// \brief Checks the screen of the progress bars through the virtual terminal
+
+#include "tesc/progress.hpp"
+#include "tesc/vt.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <ostream>
+#include <string>
+
+using namespace tesc;
+
+static auto failed = false;
+
+static void expect_line (terminal const& term, std::size_t row, std::string const& expected)
+{
+    auto line = term.line_text(row);
+
+    if (line != expected)
+    {
+        std::fprintf(stderr, "row %zu: expected '%s', got '%s'\n", row, expected.c_str(), line.c_str());
+        failed = true;
+    }
+}
+
+int main ()
+{
+    terminal term{ 6, 40 };
+    std::ostream os{ &term.buffer() };
+
+    progress bars{ os, std::chrono::milliseconds{ 50 }, 10 };
+
+    // A bar added after a redrawn one goes below all the shown lines
+    auto& a = bars.add("aa", 10);
+    bars.render();
+
+    a.advance(5);
+    auto& c = bars.add("cc", 10);
+    bars.render();
+
+    expect_line(term, 0, "aa [█████░░░░░] 50% 5/10");
+    expect_line(term, 1, "cc [░░░░░░░░░░] 0% 0/10");
+
+    // Updates of the upper bar after the lower one was added
+    a.advance(5);
+    c.advance(2);
+    auto& e = bars.add("ee", 4);
+    bars.render();
+
+    expect_line(term, 0, "aa [██████████] 100% 10/10");
+    expect_line(term, 1, "cc [██░░░░░░░░] 20% 2/10");
+    expect_line(term, 2, "ee [░░░░░░░░░░] 0% 0/4");
+    expect_line(term, 3, "");
+
+    e.set(4);
+    bars.render();
+
+    expect_line(term, 2, "ee [██████████] 100% 4/4");
+
+    // A new total alone redraws the bar: a shorter one, and a longer one
+    e.set_total(8);
+    bars.render();
+
+    expect_line(term, 2, "ee [█████░░░░░] 50% 4/8");
+
+    c.set_total(4);
+    bars.render();
+
+    expect_line(term, 1, "cc [█████░░░░░] 50% 2/4");
+
+    if (term.cursor_row() != 3 || term.cursor_col() != 0)
+    {
+        std::fprintf(stderr, "cursor at %zu:%zu instead of 3:0\n", term.cursor_row(), term.cursor_col());
+        failed = true;
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,89 @@
+// Copyright © 2020-2021 Alex Qzminsky.
+// License: MIT. All rights reserved.
+
+/// \brief Checks that a set of expressions finds the same matches as each of them alone
+
+#include "tesc/regex.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace tesc;
+
+using match = std::tuple<std::size_t, std::size_t, std::size_t>;
+
+static auto failed = false;
+
+static void compare (std::vector<std::string> const& patterns, std::string const& text)
+{
+    regex_set set;
+    std::vector<match> expected, found;
+
+    for (auto& p : patterns)
+    {
+        auto id = set.add(p);
+        regex{ p }.scan(text, [&] (std::size_t first, std::size_t last) { expected.emplace_back(id, first, last); });
+    }
+    set.build();
+    set.scan(text, [&] (std::size_t id, std::size_t first, std::size_t last) { found.emplace_back(id, first, last); });
+
+    std::sort(expected.begin(), expected.end());
+    std::sort(found.begin(), found.end());
+
+    if (found != expected)
+    {
+        std::fprintf(stderr, "text '%s', patterns:", text.c_str());
+        for (auto& p : patterns) std::fprintf(stderr, " '%s'", p.c_str());
+        std::fprintf(stderr, "\n");
+
+        for (auto& [id, first, last] : expected) std::fprintf(stderr, "  expected %zu [%zu, %zu)\n", id, first, last);
+        for (auto& [id, first, last] : found) std::fprintf(stderr, "  found    %zu [%zu, %zu)\n", id, first, last);
+
+        failed = true;
+    }
+}
+
+int main ()
+{
+    compare({ "aa" }, "aaa");
+    compare({ "ab|bcd" }, "abcd");
+    compare({ "aa", "[0-9]+x?[0-9]" }, "aaa 1x23");
+    compare({ "^a+", "b$", "^$", "a*" }, "aab");
+    compare({ "b[a-z]*|a", "x?" }, std::string(1000, 'a'));
+
+    // Random expressions of a small alphabet on random texts
+    std::mt19937 random{ 2021 };
+    std::vector<std::string> atoms = { "a", "b", "c", ".", "[ab]", "[^a]", "(a|bc)", "(ab)", "^", "$" };
+    std::vector<std::string> quantifiers = { "", "", "*", "+", "?", "{2}", "{1,2}" };
+
+    auto pick = [&] (std::size_t n) { return (std::size_t)std::uniform_int_distribution<std::size_t>{ 0, n - 1 }(random); };
+
+    for (auto round = 0; round < 300; ++round)
+    {
+        std::vector<std::string> patterns(1 + pick(4));
+
+        for (auto& p : patterns)
+        {
+            for (auto k = 1 + pick(4); k--;)
+            {
+                auto& atom = atoms[pick(atoms.size())];
+
+                p += atom;
+                if (atom != "^" && atom != "$") p += quantifiers[pick(quantifiers.size())];
+            }
+            if (pick(3) == 0) p += "|" + atoms[pick(atoms.size())];
+        }
+
+        std::string text;
+        for (auto k = pick(24); k--;) text += "abc "[pick(4)];
+
+        compare(patterns, text);
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,41 @@
+// Copyright © 2020-2021 Alex Qzminsky.
+// License: MIT. All rights reserved.
+
+/// \brief Checks that the manipulators and the roles leave a field width to the text
+
+#include "tesc/theme.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+using namespace tesc;
+
+static auto failed = false;
+
+template <typename Manipulator>
+static void expect_padded_text (char const* name, Manipulator const& manip, std::string_view seq)
+{
+    std::ostringstream os;
+    os << std::setw(6) << manip << "ERR|";
+
+    auto expected = std::string{ seq } + "  ERR|";
+
+    if (os.str() != expected)
+    {
+        std::fprintf(stderr, "%s: the width is not applied to the text\n", name);
+        failed = true;
+    }
+}
+
+int main ()
+{
+    expect_padded_text("role", role::error, active_theme()[role::error].view());
+    expect_padded_text("color", color{ face::red }, to_escape(face::red, back::none).view());
+    expect_padded_text("font", font{ style::bold }, to_escape(style::bold).view());
+    expect_padded_text("reset", reset, reset_escape);
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
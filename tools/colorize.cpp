@@ -0,0 +1,255 @@
+// Copyright © 2020-2021 Alex Qzminsky.
+// License: MIT. All rights reserved.
+
+/// \brief Streaming log colorizer (stdin → stdout) driven by a rules file
+///
+/// \details Usage: `tesc-colorize RULES < input`. Each line of the rules file is
+/// `KIND PATTERN STYLE`, where `KIND` is `literal` or `regex`, `PATTERN` is a word or
+/// a double-quoted string, and `STYLE` is a `tesc::parse_state()` specification:
+///
+///     # Later rules take precedence over earlier ones
+///     regex   "[0-9]+ms"  yellow
+///     literal ERROR       bright-white on-red bold
+///
+/// All literals are matched by a single Aho-Corasick automaton, and all regular
+/// expressions by a single table-driven DFA in one more pass over the line. The output
+/// is accumulated in a large buffer and written when the buffer is full or the input
+/// has no more data at the moment
+
+#include "tesc/aho_corasick.hpp"
+#include "tesc/paint.hpp"
+#include "tesc/regex.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <poll.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr std::size_t block_size = 1 << 20;
+
+    /**
+     * \brief Highlighting rules compiled into the matching engines
+    */
+    struct rule_set
+    {
+        tesc::literal_set literals;
+        std::vector<uint16_t> literal_rules;                    ///< Literal identifier → rule
+        tesc::regex_set regexes;
+        std::vector<uint16_t> regex_rules;                      ///< Expression identifier → rule
+        tesc::painter canvas;                                   ///< Rule `i` paints with style `i + 1`
+    };
+
+    /**
+     * \brief Splits off the next word or double-quoted string
+    */
+    auto next_token (std::string_view& line) -> std::string_view
+    {
+        auto start = line.find_first_not_of(" \t");
+        if (start == line.npos) return line = {};
+
+        line.remove_prefix(start);
+
+        if (line.front() == '"')
+        {
+            std::size_t end = 1;
+            while (end < line.size() && line[end] != '"') end += line[end] == '\\' ? 2 : 1;
+
+            auto token = line.substr(1, std::min(end, line.size()) - 1);
+            line.remove_prefix(std::min(end + 1, line.size()));
+            return token;
+        }
+
+        auto end = std::min(line.find_first_of(" \t"), line.size());
+        auto token = line.substr(0, end);
+        line.remove_prefix(end);
+        return token;
+    }
+
+    /**
+     * \brief Loads the rules file
+    */
+    auto load_rules (char const* path, rule_set& rules) -> bool
+    {
+        std::ifstream file{ path };
+        if (!file)
+        {
+            std::fprintf(stderr, "tesc-colorize: cannot open '%s'\n", path);
+            return false;
+        }
+
+        std::string text;
+        for (auto number = 1; std::getline(file, text); ++number)
+        {
+            std::string_view line = text;
+
+            auto kind = next_token(line);
+            if (kind.empty() || kind.front() == '#') continue;
+
+            auto pattern = next_token(line);
+            auto style = tesc::parse_state(line);
+
+            if (pattern.empty() || !style)
+            {
+                std::fprintf(stderr, "tesc-colorize: %s:%d: malformed rule\n", path, number);
+                return false;
+            }
+
+            auto id = rules.canvas.add_style(*style) - 1;
+
+            if (kind == "literal")
+            {
+                // Only the quotes need escaping in literals
+                std::string unescaped;
+                for (std::size_t i = 0; i < pattern.size(); ++i)
+                {
+                    if (pattern[i] == '\\' && i + 1 < pattern.size()) ++i;
+                    unescaped += pattern[i];
+                }
+
+                rules.literals.add(unescaped);
+                rules.literal_rules.push_back((uint16_t)id);
+            }
+            else if (kind == "regex")
+            {
+                try {
+                    rules.regexes.add(pattern);
+                    rules.regex_rules.push_back((uint16_t)id);
+                }
+                catch (std::exception const& e) {
+                    std::fprintf(stderr, "tesc-colorize: %s:%d: %s\n", path, number, e.what());
+                    return false;
+                }
+            }
+            else
+            {
+                std::fprintf(stderr, "tesc-colorize: %s:%d: unknown rule kind\n", path, number);
+                return false;
+            }
+        }
+        rules.literals.build();
+
+        try {
+            rules.regexes.build();
+        }
+        catch (std::exception const& e) {
+            std::fprintf(stderr, "tesc-colorize: %s: %s\n", path, e.what());
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * \brief Writes the whole buffer to the file descriptor
+    */
+    auto write_all (int fd, std::string& out) -> bool
+    {
+        for (std::size_t done = 0; done < out.size();)
+        {
+            auto n = ::write(fd, out.data() + done, out.size() - done);
+
+            if (n > 0) done += (std::size_t)n;
+            else if (n < 0 && errno == EINTR) continue;
+            else return false;
+        }
+        out.clear();
+
+        return true;
+    }
+
+    /**
+     * \brief Checks without waiting whether the descriptor can be read (data or the end of input)
+    */
+    auto readable (int fd) -> bool
+    {
+        pollfd p{ fd, POLLIN, 0 };
+
+        for (;;)
+        {
+            auto n = ::poll(&p, 1, 0);
+
+            if (n >= 0) return n > 0;
+            if (errno != EINTR) return false;
+        }
+    }
+}
+
+int main (int argc, char** argv)
+{
+    if (argc != 2)
+    {
+        std::fprintf(stderr, "Usage: %s RULES < input\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    rule_set rules;
+    if (!load_rules(argv[1], rules)) return EXIT_FAILURE;
+
+    std::vector<char> in(block_size);
+    std::size_t pending = 0;                                    ///< Incomplete line from the previous block
+
+    std::string out;
+    out.reserve(2 * block_size);
+
+    std::vector<std::tuple<uint16_t, std::size_t, std::size_t>> matches;
+
+    auto process = [&] (std::string_view line)
+    {
+        matches.clear();
+
+        rules.literals.scan(line, [&] (std::size_t id, std::size_t first, std::size_t last) {
+            matches.emplace_back(rules.literal_rules[id], first, last);
+        });
+        rules.regexes.scan(line, [&] (std::size_t id, std::size_t first, std::size_t last) {
+            matches.emplace_back(rules.regex_rules[id], first, last);
+        });
+
+        rules.canvas.begin(line.size());
+
+        // Painting in the rules order, so that later rules override earlier ones
+        std::stable_sort(matches.begin(), matches.end(), [] (auto& a, auto& b) { return std::get<0>(a) < std::get<0>(b); });
+        for (auto& [rule, first, last] : matches) rules.canvas.paint(first, last, (uint16_t)(rule + 1));
+
+        rules.canvas.emit(out, line);
+    };
+
+    for (;;)
+    {
+        if (pending == in.size()) in.resize(in.size() * 2);
+
+        auto n = ::read(STDIN_FILENO, in.data() + pending, in.size() - pending);
+
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+
+        std::string_view block{ in.data(), pending + (std::size_t)n };
+        std::size_t start = 0;
+
+        for (auto eol = block.find('\n'); eol != block.npos; eol = block.find('\n', start))
+        {
+            process(block.substr(start, eol - start));
+            out += '\n';
+            start = eol + 1;
+
+            if (out.size() >= block_size && !write_all(STDOUT_FILENO, out)) return EXIT_FAILURE;
+        }
+
+        pending = block.size() - start;
+        std::copy(block.begin() + (std::ptrdiff_t)start, block.end(), in.begin());
+
+        // Nothing more at the moment: showing what we have (important for `tail -f`)
+        if (!readable(STDIN_FILENO) && !write_all(STDOUT_FILENO, out)) return EXIT_FAILURE;
+    }
+
+    if (pending) process({ in.data(), pending });
+
+    return write_all(STDOUT_FILENO, out) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
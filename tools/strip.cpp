@@ -0,0 +1,138 @@
+// Copyright © 2020-2021 Alex Qzminsky.
+// License: MIT. All rights reserved.
+
+/// \brief Parallel stripping of escape sequences from captured console output
+///
+/// \details Usage: `tesc-strip [--sgr] [-j THREADS] INPUT [OUTPUT]`. The input file is
+/// mapped into memory and converted by chunks on a pool of threads; the results are
+/// written in order to `OUTPUT` or to `stdout`. By default all the escape sequences are
+/// removed; with `--sgr`, only colors and styles are kept
+
+#include "tesc/ansi.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    /**
+     * \brief Read-only memory mapping of a whole file
+    */
+    class mapped_file
+    {
+        void* _data = MAP_FAILED;
+        std::size_t _size = 0;
+
+    public:
+
+        explicit mapped_file (char const* path)
+        {
+            auto fd = ::open(path, O_RDONLY);
+            if (fd < 0) return;
+
+            struct stat info;
+
+            if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode))
+            {
+                _size = (std::size_t)info.st_size;
+                _data = _size ? ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+
+                if (_data != MAP_FAILED && _size) ::madvise(_data, _size, MADV_SEQUENTIAL);
+            }
+            ::close(fd);
+        }
+
+        mapped_file (mapped_file const&) = delete;
+        auto operator = (mapped_file const&) -> mapped_file& = delete;
+
+        ~mapped_file ()
+        {
+            if (_data != MAP_FAILED && _size) ::munmap(_data, _size);
+        }
+
+        explicit operator bool () const
+        {
+            return _data != MAP_FAILED;
+        }
+
+        auto view () const -> std::string_view
+        {
+            return { (char const*)_data, _size };
+        }
+    };
+
+    /**
+     * \brief Writes the whole buffer to the file descriptor
+    */
+    auto write_all (int fd, std::string_view out) -> bool
+    {
+        while (!out.empty())
+        {
+            auto n = ::write(fd, out.data(), out.size());
+
+            if (n > 0) out.remove_prefix((std::size_t)n);
+            else if (n < 0 && errno == EINTR) continue;
+            else return false;
+        }
+        return true;
+    }
+}
+
+int main (int argc, char** argv)
+{
+    auto sgr = false;
+    auto threads = 0u;
+    char const* paths[2] = {};
+    auto npaths = 0;
+
+    for (auto i = 1; i < argc; ++i)
+    {
+        if (!std::strcmp(argv[i], "--sgr")) sgr = true;
+        else if (!std::strcmp(argv[i], "-j") && i + 1 < argc) threads = (unsigned)std::atoi(argv[++i]);
+        else if (npaths < 2 && argv[i][0] != '-') paths[npaths++] = argv[i];
+        else
+        {
+            npaths = 0;
+            break;
+        }
+    }
+
+    if (npaths < 1)
+    {
+        std::fprintf(stderr, "Usage: %s [--sgr] [-j THREADS] INPUT [OUTPUT]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    mapped_file input{ paths[0] };
+    if (!input)
+    {
+        std::fprintf(stderr, "tesc-strip: cannot map '%s' (a regular file is required)\n", paths[0]);
+        return EXIT_FAILURE;
+    }
+
+    auto fd = STDOUT_FILENO;
+    if (paths[1] && (fd = ::open(paths[1], O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+    {
+        std::fprintf(stderr, "tesc-strip: cannot open '%s': %s\n", paths[1], std::strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    auto ok = true;
+    auto sink = [&] (std::string_view converted) { ok = ok && write_all(fd, converted); };
+
+    if (sgr) tesc::convert_parallel(input.view(), tesc::keep_sgr, sink, threads);
+    else tesc::convert_parallel(input.view(), tesc::strip_escapes, sink, threads);
+
+    if (paths[1]) ok = ::close(fd) == 0 && ok;
+    if (!ok) std::fprintf(stderr, "tesc-strip: write error: %s\n", std::strerror(errno));
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}